@@ -0,0 +1,285 @@
+﻿/**
+ * @file ZooBench.cpp
+ * @brief Микробенчмарки ядра симуляции (цель zoo_bench).
+ * @details Подключает ZooSimulator.cpp без функции main и замеряет основные операции
+ * на зоопарках от 10 до 10^7 животных. Для каждой пары (операция, размер) печатаются
+ * наносекунды на операцию, выделения памяти на операцию и обработанные элементы в секунду.
+ *
+ * Сборка: g++ -O2 -std=c++17 -pthread -o zoo_bench ZooBench.cpp
+ */
+
+#define ZOO_NO_MAIN
+#define ZOO_COUNT_ALLOCATIONS
+#include "ZooSimulator.cpp"
+
+#include <cstdio>
+
+// Выделения памяти считает operator new из ZooSimulator.cpp (allocationCount, включён ZOO_COUNT_ALLOCATIONS)
+
+/**
+ * @brief Параметры запуска бенчмарков.
+ */
+struct BenchOptions {
+    size_t minPopulation = 10;        ///< Наименьший размер зоопарка
+    size_t maxPopulation = 10000000;  ///< Наибольший размер зоопарка
+    double minSeconds = 0.2;          ///< Минимальное время замера одной пары (операция, размер)
+    string filter;                    ///< Подстрока имени бенчмарка (пусто — все)
+    bool csv = false;                 ///< Вывод в CSV вместо таблицы
+    uint64_t seed = 1;                ///< Зерно построения зоопарков
+    string cacheDir;                  ///< Каталог снимков построенных зоопарков (пусто — строить каждый раз)
+};
+
+/**
+ * @brief Результат замера одной пары (операция, размер).
+ */
+struct BenchResult {
+    string name;          ///< Имя бенчмарка
+    size_t population;    ///< Животных в зоопарке
+    uint64_t iterations;  ///< Выполнено операций
+    double nsPerOp;       ///< Наносекунд на операцию
+    double allocsPerOp;   ///< Выделений памяти на операцию
+    double itemsPerSec;   ///< Обработанных элементов в секунду
+};
+
+/// Приёмник результатов, чтобы компилятор не выбросил замеряемые вызовы
+volatile long long benchSink = 0;
+
+/**
+ * @brief Замеряет операцию, повторяя её пачками, пока не наберётся minSeconds.
+ * @details Размер пачки удваивается, пока пачка не станет заметной на фоне вызова часов.
+ * Восстановление состояния (reset) выполняется между пачками и в замер не входит.
+ * @param name Имя бенчмарка
+ * @param population Животных в зоопарке
+ * @param itemsPerOp Сколько элементов обрабатывает одна операция
+ * @param resetEvery Через сколько операций восстанавливать состояние (0 — никогда)
+ * @param op Операция
+ * @param reset Восстановление состояния
+ * @param minSeconds Минимальное время замера
+ */
+template <typename Op, typename Reset>
+BenchResult measure(const string& name, size_t population, double itemsPerOp, uint64_t resetEvery,
+    Op op, Reset reset, double minSeconds) {
+    uint64_t iterations = 0, allocations = 0, chunk = 1;
+    double seconds = 0;
+    while (seconds < minSeconds) {
+        uint64_t count = resetEvery ? min(chunk, resetEvery - iterations % resetEvery) : chunk;
+        uint64_t allocationsBefore = allocationCount.load(memory_order_relaxed);
+        auto start = chrono::steady_clock::now();
+        for (uint64_t k = 0; k < count; ++k) op();
+        double elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        allocations += allocationCount.load(memory_order_relaxed) - allocationsBefore;
+        seconds += elapsed;
+        iterations += count;
+        if (resetEvery && iterations % resetEvery == 0) reset();
+        if (elapsed < minSeconds / 20 && (!resetEvery || chunk < resetEvery)) chunk *= 2;
+    }
+    return { name, population, iterations, seconds * 1e9 / iterations,
+        static_cast<double>(allocations) / iterations, itemsPerOp * iterations / seconds };
+}
+
+/**
+ * @brief Строит зоопарк для замеров генератором generateZoo: по вольеру на климат.
+ * @details Популярность обнулена, чтобы доход при 10^7 животных не переполнял int,
+ * денег и еды хватает на все замеры nextDay.
+ * Если задан каталог кэша, зоопарк загружается из снимка, а построенный впервые — сохраняется.
+ * @param population Количество животных (округляется вниз до кратного 4)
+ * @param seed Зерно генераторов
+ * @param cacheDir Каталог снимков или пустая строка
+ * @return Построенный зоопарк.
+ */
+unique_ptr<Zoo> buildBenchZoo(size_t population, uint64_t seed, const string& cacheDir) {
+    auto zoo = make_unique<Zoo>("Бенчмарк", 2000000000, seed);
+    string cachePath = cacheDir.empty() ? ""
+        : cacheDir + "/bench_" + to_string(population) + "_" + to_string(seed) + ".zoo";
+    if (!cachePath.empty() && ifstream(cachePath).good()) {
+        loadZooSnapshot(*zoo, cachePath);
+        return zoo;
+    }
+    zoo->popularity = 0;
+    zoo->food = 1000000000;
+    zoo->hireEmployee("Егор Потрошила", "Директор", 50, 50);
+    ZooGeneratorOptions options;
+    options.capacity = static_cast<int>(population / 4);
+    options.fill = 1.0;
+    generateZoo(*zoo, options);
+    if (!cachePath.empty()) saveZooSnapshot(*zoo, cachePath);
+    return zoo;
+}
+
+/**
+ * @brief Самый населённый вольер зоопарка.
+ */
+Enclosure& largestEnclosure(Zoo& zoo) {
+    return *max_element(zoo.enclosures.begin(), zoo.enclosures.end(),
+        [](const Enclosure& a, const Enclosure& b) { return a.animals.size() < b.animals.size(); });
+}
+
+/**
+ * @brief Заражает каждое десятое животное вольера и запоминает флаги заражения.
+ * @return Флаги заражения по строкам.
+ */
+vector<bool> seedInfection(Enclosure& enc) {
+    vector<bool> infected(enc.animals.size());
+    for (size_t i = 0; i < enc.animals.size(); i += 10) {
+        enc.animals.setInfected(i, true);
+        infected[i] = true;
+    }
+    return infected;
+}
+
+/**
+ * @brief Возвращает флаги заражения вольера к запомненным.
+ */
+void restoreInfection(Enclosure& enc, const vector<bool>& infected) {
+    for (size_t i = 0; i < infected.size(); ++i) {
+        enc.animals.setInfected(i, infected[i]);
+    }
+}
+
+/**
+ * @brief Выполняет все бенчмарки для одного размера зоопарка.
+ * @param population Количество животных
+ * @param options Параметры запуска
+ * @param report Вызывается для каждого результата
+ */
+void runBenchmarks(size_t population, const BenchOptions& options, const function<void(const BenchResult&)>& report) {
+    auto selected = [&](const string& name, size_t maxPopulation) {
+        return population <= maxPopulation && (options.filter.empty() || name.find(options.filter) != string::npos);
+    };
+    const double T = options.minSeconds;
+    OutputSink silent(OutputSink::SILENT);
+    SinkScope scope(silent);
+    unique_ptr<Zoo> base = buildBenchZoo(population, options.seed, options.cacheDir);
+    population = base->getTotalAnimals();
+
+    if (selected("nextDay", SIZE_MAX)) {
+        // Каждые 30 дней зоопарк восстанавливается из исходного, чтобы население не вымирало;
+        // копия сразу отделяется от исходного, чтобы копирование столбцов не попало в замер
+        unique_ptr<Zoo> zoo = make_unique<Zoo>(*base);
+        zoo->unshare();
+        report(measure("nextDay", population, static_cast<double>(population), 30,
+            [&]() { zoo->nextDay(); },
+            [&]() { zoo = make_unique<Zoo>(*base); zoo->unshare(); }, T));
+    }
+    if (selected("fork", SIZE_MAX)) {
+        uint32_t branch = 0;
+        report(measure("fork", population, static_cast<double>(population), 0,
+            [&]() { benchSink = base->fork(++branch)->money; },
+            []() {}, T));
+    }
+    for (SpreadMode mode : { SpreadMode::BINOMIAL, SpreadMode::LEGACY }) {
+        bool legacy = mode == SpreadMode::LEGACY;
+        string name = legacy ? "spreadVirus/legacy" : "spreadVirus";
+        if (!selected(name, legacy ? 100000 : SIZE_MAX)) continue; // Прежний алгоритм квадратичен
+        Zoo zoo(*base);
+        zoo.unshare();
+        Enclosure& enc = largestEnclosure(zoo);
+        vector<bool> infected = seedInfection(enc);
+        report(measure(name, population, static_cast<double>(enc.animals.size()), 1,
+            [&]() { benchSink = enc.spreadVirus(mode); },
+            [&]() { restoreInfection(enc, infected); }, T));
+    }
+    if (selected("breedingPair", SIZE_MAX)) {
+        const Enclosure& enc = largestEnclosure(*base);
+        int parent1 = -1, parent2 = -1;
+        report(measure("breedingPair", population, 1, 0,
+            [&]() { benchSink = enc.findBreedingPair(base->day, parent1, parent2) + parent2; },
+            []() {}, T));
+    }
+    if (selected("combineSpecies", SIZE_MAX)) {
+        const AnimalStore& animals = largestEnclosure(*base).animals;
+        Rng rng = Rng::stream(options.seed, RNG_BREEDING, 1);
+        size_t i = 0;
+        report(measure("combineSpecies", population, 1, 0,
+            [&]() {
+                SpeciesId first = animals.species[i % animals.size()];
+                SpeciesId second = animals.species[(i + 1) % animals.size()];
+                benchSink = combineSpecies(first, second, rng);
+                i++;
+            },
+            []() {}, T));
+    }
+    if (selected("generateAnimalMarket", SIZE_MAX)) {
+        report(measure("generateAnimalMarket", population, 10, 0,
+            [&]() { base->generateAnimalMarket(); },
+            []() {}, T));
+    }
+    if (selected("calculateDailyCost", SIZE_MAX)) {
+        const Enclosure& enc = largestEnclosure(*base);
+        report(measure("calculateDailyCost", population, 1, 0,
+            [&]() { benchSink = enc.calculateDailyCost(); },
+            []() {}, T));
+    }
+    if (selected("getTotalAnimals", SIZE_MAX)) {
+        report(measure("getTotalAnimals", population, 1, 0,
+            [&]() { benchSink = base->getTotalAnimals(); },
+            []() {}, T));
+    }
+}
+
+/**
+ * @brief Разбирает аргументы командной строки.
+ * @throws runtime_error Если аргумент неизвестен или не содержит значения.
+ */
+BenchOptions parseBenchOptions(int argc, char* argv[]) {
+    BenchOptions options;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg == "--csv") {
+            options.csv = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            throw runtime_error("Не указано значение для " + arg);
+        }
+        string value = argv[++i];
+        if (arg == "--min") options.minPopulation = stoull(value);
+        else if (arg == "--max") options.maxPopulation = stoull(value);
+        else if (arg == "--time") options.minSeconds = stod(value);
+        else if (arg == "--filter") options.filter = value;
+        else if (arg == "--seed") options.seed = stoull(value);
+        else if (arg == "--cache") options.cacheDir = value;
+        else throw runtime_error("Неизвестный аргумент: " + arg);
+    }
+    return options;
+}
+
+/**
+ * @brief Запускает бенчмарки для размеров 10, 100, ..., 10^7 в пределах --min/--max.
+ * @details Аргументы: --min N, --max N, --time секунд, --filter подстрока, --seed N,
+ * --cache каталог (снимки построенных зоопарков), --csv.
+ * @return 0 при успехе, 2 при ошибке в аргументах.
+ */
+int main(int argc, char* argv[]) {
+    BenchOptions options;
+    try {
+        options = parseBenchOptions(argc, argv);
+    }
+    catch (const exception& e) {
+        cerr << "Ошибка: " << e.what() << "\n";
+        return 2;
+    }
+
+    if (options.csv) {
+        cout << "benchmark,population,iterations,ns_per_op,allocs_per_op,items_per_sec\n";
+    }
+    else {
+        printf("%-22s %10s %12s %14s %10s %16s\n", "benchmark", "animals", "iterations", "ns/op", "allocs/op", "items/s");
+    }
+    auto report = [&](const BenchResult& r) {
+        if (options.csv) {
+            printf("%s,%zu,%llu,%.1f,%.3f,%.0f\n", r.name.c_str(), r.population,
+                static_cast<unsigned long long>(r.iterations), r.nsPerOp, r.allocsPerOp, r.itemsPerSec);
+        }
+        else {
+            printf("%-22s %10zu %12llu %14.1f %10.3f %16.0f\n", r.name.c_str(), r.population,
+                static_cast<unsigned long long>(r.iterations), r.nsPerOp, r.allocsPerOp, r.itemsPerSec);
+        }
+        fflush(stdout);
+    };
+    for (size_t population = 10; population <= options.maxPopulation; population *= 10) {
+        if (population < options.minPopulation) continue;
+        runBenchmarks(population, options, report);
+    }
+    return 0;
+}
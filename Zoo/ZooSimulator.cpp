@@ -11,1665 +11,6745 @@
 #include <string>
 #include <limits>
 #include <cstdlib>
+#include <cassert>
 #include <ctime>
 #include <vector>
 #include <functional>
+#include <cstdint>
+#include <unordered_map>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <algorithm>
+#include <cmath>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <cstdio>
+#include <cerrno>
+#include <cstring>
+#include <array>
+#include <new>
+#include <csignal>
+#include <shared_mutex>
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <poll.h>
+#include <sys/resource.h>
+#endif
 
 
 using namespace std;
+
+#ifdef ZOO_COUNT_ALLOCATIONS
+/// Количество вызовов operator new с начала программы (сервер показателей, zoo_bench)
+atomic<uint64_t> allocationCount{ 0 };
+/// Запрошено байт через operator new с начала программы
+atomic<uint64_t> allocatedBytes{ 0 };
+
+// noinline: иначе GCC видит пару new/free после встраивания и выдаёт -Wmismatched-new-delete
+#if defined(__GNUC__)
+#define ZOO_NOINLINE __attribute__((noinline))
+#else
+#define ZOO_NOINLINE
+#endif
+
+ZOO_NOINLINE void* operator new(size_t size) {
+    allocationCount.fetch_add(1, memory_order_relaxed);
+    allocatedBytes.fetch_add(size, memory_order_relaxed);
+    if (void* p = malloc(size ? size : 1)) return p;
+    throw bad_alloc();
+}
+ZOO_NOINLINE void operator delete(void* p) noexcept {
+    free(p);
+}
+ZOO_NOINLINE void operator delete(void* p, size_t) noexcept {
+    free(p);
+}
+#endif // ZOO_COUNT_ALLOCATIONS
+
 /**
  * @brief Функция для получения целочисленного ввода от пользователя.
  * @param prompt Сообщение, выводимое пользователю перед запросом ввода.
  * @return Целочисленное значение, введенное пользователем.
  */
 int getIntegerInput(const string& prompt);
+/**
+ * @brief Считывает строку ввода целиком.
+ * @return Строка без символа перевода строки.
+ */
+string getLineInput();
 
 class Zoo; // Предварительное объявление класса Zoo
+/**
+ * @brief Печатает прогноз зоопарка на 10 дней по развилкам (см. forecastZoo).
+ * @param zoo Зоопарк
+ * @param title Название действия для сводки
+ * @param action Действие игрока или пустая функция
+ */
+void showForecast(const Zoo& zoo, const string& title, const function<void(Zoo&)>& action);
 
-// Функция для разделения строки на слова
-vector<string> splitString(const string& str) {
-    vector<string> words;
-    string word;
-    for (char c : str) {
-        if (c == ' ') {
-            if (!word.empty()) {
-                words.push_back(word);
-                word.clear();
-            }
-        }
-        else {
-            word += c;
+/**
+ * @brief Уровни сообщений моделирования.
+ */
+enum class LogLevel : uint8_t {
+    TRACE,   ///< Заражения отдельных животных (много сообщений на больших зоопарках)
+    INFO,    ///< Отчёт дня: бюджет, посетители, доход
+    NOTICE   ///< События дня и смерти животных
+};
+
+/**
+ * @brief Буфер, копящий текст в памяти и сбрасывающий его в целевой поток крупными кусками.
+ */
+class BatchBuffer : public streambuf {
+public:
+    /**
+     * @param target Целевой поток
+     * @param limit Размер, после которого накопленное сбрасывается
+     */
+    BatchBuffer(ostream& target, size_t limit) : target(target), limit(limit) {}
+    /**
+     * @brief Записывает накопленное в целевой поток.
+     */
+    int sync() override {
+        target.write(text.data(), static_cast<streamsize>(text.size()));
+        target.flush();
+        text.clear();
+        return 0;
+    }
+
+protected:
+    int_type overflow(int_type ch) override {
+        if (ch != traits_type::eof()) {
+            text.push_back(traits_type::to_char_type(ch));
+            if (text.size() >= limit) sync();
         }
+        return ch;
     }
-    if (!word.empty()) {
-        words.push_back(word);
+    streamsize xsputn(const char* s, streamsize n) override {
+        text.append(s, static_cast<size_t>(n));
+        if (text.size() >= limit) sync();
+        return n;
     }
-    return words;
-}
-
-// Функция для комбинирования видов
-string combineSpecies(const string& species1, const string& species2) {
-    // Разделяем виды на слова
-    vector<string> words1 = splitString(species1);
-    vector<string> words2 = splitString(species2);
-
-    // Выбираем случайное слово из первого вида
-    string part1 = words1[rand() % words1.size()];
 
-    // Выбираем случайное слово из второго вида
-    string part2 = words2[rand() % words2.size()];
+private:
+    ostream& target; ///< Куда сбрасывается текст
+    size_t limit;    ///< Порог сброса в байтах
+    string text;     ///< Накопленный текст
+};
 
-    // Собираем новый вид
-    return part1 + " " + part2;
-}
 /**
- * @brief Класс для представления животного.
+ * @brief Приёмник сообщений моделирования: события дня, болезни, смерти.
+ * @details Сообщения пишутся макросом ZOO_LOG, который проверяет enabled() до того,
+ * как вычислить выражение сообщения, поэтому отброшенные сообщения не форматируются.
+ * Режимы: CONSOLE — сразу в поток (интерактивная игра), BUFFERED — через буфер,
+ * который сбрасывается кусками по 64 КБ и в деструкторе (пакетные прогоны с выводом),
+ * SILENT — ничего не выводится.
  */
-class Animal {
+class OutputSink {
 public:
-    enum Type { LAND, AQUATIC }; // Типы животных: Земноводные и Водоплавающие
-
-    string name;         ///< Имя животного
-    string species;      ///< Вид животного
-    int ageInDays;       ///< Возраст в днях
-    int weight;          ///< Вес
-    enum Climate { DESERT, FOREST, ARCTIC, OCEAN } climate; ///< Климат
-    bool isCarnivore;    ///< Хищник или травоядное
-    bool isInfected;     ///< Заражено ли животное
-    char gender;         ///< Пол ('М' или 'Ж')
-    pair<string, string> parents; ///< Имена родителей
-    Type type;
+    enum Mode { CONSOLE, BUFFERED, SILENT };
 
     /**
-     * @brief Конструктор для создания нового животного.
-     * @param n Имя животного
-     * @param s Вид животного
-     * @param a Возраст в днях
-     * @param w Вес
-     * @param c Климат
-     * @param carn Является ли хищником
-     * @param g Пол ('M' или 'F')
-     * @param t Тип животного ('Land' или 'Aquatic')
-     * @param parent1 Имя первого родителя (по умолчанию пустая строка)
-     * @param parent2 Имя второго родителя (по умолчанию пустая строка)
+     * @param mode Режим вывода
+     * @param level Наименьший выводимый уровень
+     * @param target Целевой поток
      */
+    explicit OutputSink(Mode mode = CONSOLE, LogLevel level = LogLevel::TRACE, ostream& target = cout)
+        : mode(mode), level(level), target(target), batch(target, 64 * 1024), batched(&batch) {}
+    ~OutputSink() {
+        flush();
+    }
+    OutputSink(const OutputSink&) = delete;
+    OutputSink& operator=(const OutputSink&) = delete;
 
-     // Конструктор
-    Animal(string n, string s, int a, int w, Climate c, bool carn, char g, Type t, string parent1 = "", string parent2 = "")
-        : name(n), species(s), ageInDays(a), weight(w), climate(c), isCarnivore(carn), gender(g), type(t), parents({ parent1, parent2 }), isInfected(false) {}
-
-    // Метод для проверки, является ли животное водоплавающим
-    bool isAquatic() const {
-        return type == AQUATIC;
+    /**
+     * @brief Будет ли выведено сообщение уровня level.
+     */
+    bool enabled(LogLevel messageLevel) const {
+        return mode != SILENT && messageLevel >= level;
     }
     /**
-     * @brief Рассчитывает цену животного если оно водоплавающее.
-     * @return Вес животного.
+     * @brief Поток для текста сообщения; писать в него стоит только после проверки enabled().
      */
-    int calculateMaintenanceCost() const {
-        if (isAquatic()) {
-            return weight * 2; // Удвоенная стоимость содержания для водоплавающих
-        }
-        return weight;
+    ostream& stream() {
+        return mode == BUFFERED ? batched : target;
     }
     /**
-     * @brief Рассчитывает цену животного на основе его характеристик.
-     * @return Цена животного в монетах.
+     * @brief Сбрасывает накопленные сообщения в целевой поток.
      */
-    int calculatePrice() const {
-        int basePrice = 60;
-        int price = basePrice + weight * 2 - ageInDays / 30 * 5;
-        price += isCarnivore ? 100 : 0;
-        price += static_cast<int>(climate) * 50;
+    void flush() {
+        if (mode == BUFFERED) batch.pubsync();
+    }
 
-        if (isAquatic()) {
-            price += 200; // Например, дополнительная стоимость для водоплавающих
-        }
+private:
+    Mode mode;          ///< Режим вывода
+    LogLevel level;     ///< Наименьший выводимый уровень
+    ostream& target;    ///< Целевой поток
+    BatchBuffer batch;  ///< Буфер режима BUFFERED
+    ostream batched;    ///< Поток поверх batch
+};
 
-        return max(price, 10);
+/**
+ * @brief Приёмник по умолчанию: консоль, все уровни.
+ */
+thread_local OutputSink consoleSink;
+/**
+ * @brief Приёмник сообщений текущего потока выполнения.
+ * @details Указатель свой у каждого потока выполнения, поэтому параллельные
+ * прогоны могут молчать, не трогая общий cout.
+ */
+thread_local OutputSink* simulationSink = nullptr;
+
+/**
+ * @brief Возвращает приёмник сообщений моделирования текущего потока выполнения.
+ */
+OutputSink& simSink() {
+    return simulationSink ? *simulationSink : consoleSink;
+}
+
+/**
+ * @brief Подключает приёмник к текущему потоку выполнения до конца области видимости.
+ */
+class SinkScope {
+public:
+    explicit SinkScope(OutputSink& sink) : saved(simulationSink) {
+        simulationSink = &sink;
     }
+    ~SinkScope() {
+        simulationSink = saved;
+    }
+    SinkScope(const SinkScope&) = delete;
+    SinkScope& operator=(const SinkScope&) = delete;
+private:
+    OutputSink* saved; ///< Приёмник, который был до подключения
+};
+
+/**
+ * @brief Пишет сообщение моделирования уровня level.
+ * @details message — цепочка операндов operator<<; она не вычисляется, если уровень отключён.
+ */
+#define ZOO_LOG(level, message) \
+    do { \
+        OutputSink& zooSink = simSink(); \
+        if (zooSink.enabled(level)) zooSink.stream() << message; \
+    } while (0)
+
+/**
+ * @brief Ввод закончился: в сценарии или в консоли больше нет строк.
+ */
+class InputExhausted : public runtime_error {
+public:
+    InputExhausted() : runtime_error("Ввод закончился") {}
+};
+
+/**
+ * @brief Источник строк ввода для меню.
+ */
+class InputSource {
+public:
+    virtual ~InputSource() = default;
     /**
-     * @brief Увеличивает возраст животного на один день.
+     * @brief Читает следующую строку.
+     * @param line Сюда записывается строка без символа перевода строки
+     * @return false, если строк больше нет.
      */
-    void growOlder() {
-        ageInDays++;
+    virtual bool readLine(string& line) = 0;
+};
+
+/**
+ * @brief Ввод с клавиатуры построчно через cin.
+ */
+class ConsoleInput : public InputSource {
+public:
+    bool readLine(string& line) override {
+        return static_cast<bool>(getline(cin, line));
+    }
+};
+
+/**
+ * @brief Ввод из потока FILE*, читаемого кусками по 64 КБ.
+ * @details Строки вырезаются из буфера без обращения к потоку на каждую строку,
+ * поэтому записанный сеанс из тысяч команд проходит со скоростью разбора.
+ */
+class ChunkedInput : public InputSource {
+public:
+    static const size_t CHUNK_SIZE = 64 * 1024; ///< Размер куска чтения
+
+    bool readLine(string& line) override {
+        while (true) {
+            size_t end = buffer.find('\n', pos);
+            if (end != string::npos) {
+                line.assign(buffer, pos, end - pos);
+                pos = end + 1;
+                break;
+            }
+            if (!refill()) {
+                if (pos >= buffer.size()) return false;
+                line.assign(buffer, pos, string::npos); // Последняя строка без перевода строки
+                pos = buffer.size();
+                break;
+            }
+        }
+        if (!line.empty() && line.back() == '\r') line.pop_back(); // Файлы, записанные в Windows
+        return true;
+    }
+
+protected:
+    FILE* file = nullptr; ///< Поток, из которого читаются куски
+
+private:
+    string buffer;  ///< Прочитанный, но ещё не разобранный текст начиная с pos
+    size_t pos = 0; ///< Начало неразобранного текста
+
+    bool refill() {
+        if (!file) return false;
+        buffer.erase(0, pos);
+        pos = 0;
+        size_t old = buffer.size();
+        buffer.resize(old + CHUNK_SIZE);
+        size_t got = fread(&buffer[old], 1, CHUNK_SIZE, file);
+        buffer.resize(old + got);
+        return got > 0;
     }
+};
+
+/**
+ * @brief Ввод из файла; "-" — стандартный ввод (например, перенаправленный из канала).
+ */
+class FileInput : public ChunkedInput {
+public:
     /**
-     * @brief Вывод родителей животного.
+     * @param path Путь к файлу или "-"
+     * @throws runtime_error Если файл не открывается.
      */
-    void printParents() const {
-        if (parents.first.empty() && parents.second.empty()) {
-            cout << "Родители неизвестны";
-        }
-        else {
-            cout << "Родители: " << parents.first << " и " << parents.second;
-        }
+    explicit FileInput(const string& path) : owned(path != "-") {
+        file = owned ? fopen(path.c_str(), "rb") : stdin;
+        if (!file) throw runtime_error("Не удалось открыть файл сценария: " + path);
     }
+    ~FileInput() override {
+        if (owned) fclose(file);
+    }
+
+private:
+    bool owned; ///< Файл открыт нами и закрывается в деструкторе
+};
+
+/**
+ * @brief Ввод из канала: вывод запущенной команды.
+ */
+class PipeInput : public ChunkedInput {
+public:
     /**
-     * @brief Проверяет, умрет ли животное от старости.
-     * @return true, если животное умирает от старости, иначе false.
+     * @param command Команда оболочки, чей вывод становится вводом
+     * @throws runtime_error Если команда не запускается.
      */
-    bool diesOfOldAge() const {
-        if (ageInDays > 60) { // Пример: максимальный возраст = 60 дней
-            int deathChance = ageInDays - 60; // Шанс смерти = возраст - 60
-            return rand() % 100 < deathChance;
-        }
-        return false;
+    explicit PipeInput(const string& command) {
+#ifdef _WIN32
+        file = _popen(command.c_str(), "rb");
+#else
+        file = popen(command.c_str(), "r");
+#endif
+        if (!file) throw runtime_error("Не удалось запустить команду сценария: " + command);
+    }
+    ~PipeInput() override {
+#ifdef _WIN32
+        _pclose(file);
+#else
+        pclose(file);
+#endif
     }
+};
 
+/**
+ * @brief Сценарий в памяти: строки берутся из готового текста.
+ */
+class ScriptInput : public InputSource {
+public:
     /**
-     * @brief Перегрузка оператора + для размножения животных.
-     * @param other Второе животное для размножения.
-     * @return Новое животное, полученное в результате размножения.
-     * @throws runtime_error Если размножение невозможно.
+     * @param script Текст сценария, строки разделены '\n'
      */
-    Animal operator+(const Animal& other) {
-        if (this->gender == other.gender) {
-            throw runtime_error("Одинаковый пол! Размножение невозможно.");
-        }
-        if (this->species == other.species) {
-            throw runtime_error("Животные одного вида не могут размножаться.");
-        }
+    explicit ScriptInput(string script) : text(move(script)) {}
+
+    bool readLine(string& line) override {
+        if (pos >= text.size()) return false;
+        size_t end = text.find('\n', pos);
+        if (end == string::npos) end = text.size();
+        line.assign(text, pos, end - pos);
+        pos = end + 1;
+        return true;
+    }
 
-        // Генерация нового вида
-        string newSpecies = combineSpecies(this->species, other.species);
+private:
+    string text;    ///< Текст сценария
+    size_t pos = 0; ///< Начало следующей строки
+};
 
-        // Генерация случайного пола
-        char newGender = rand() % 2 == 0 ? 'M' : 'F';
+/**
+ * @brief Источник ввода меню; nullptr — консоль.
+ */
+InputSource* inputSource = nullptr;
 
-        // Определяем тип потомка
-        Type newType = this->isAquatic() || other.isAquatic() ? AQUATIC : LAND;
+/**
+ * @brief Возвращает текущий источник ввода меню.
+ */
+InputSource& input() {
+    static ConsoleInput console;
+    return inputSource ? *inputSource : console;
+}
 
-        // Создаем новое животное
-        return Animal(
-            "",                          // Имя (пустое, так как пользователь задаст его позже)
-            newSpecies,                  // Новый вид
-            1,                           // Возраст (1 день)
-            (this->weight + other.weight) / 2, // Средний вес
-            this->climate,               // Климат
-            this->isCarnivore || other.isCarnivore, // Тип питания
-            newGender,                  // Пол
-            newType                      // Тип животного
-        );
+/**
+ * @brief Подключает источник ввода меню до конца области видимости.
+ */
+class InputScope {
+public:
+    explicit InputScope(InputSource& source) : saved(inputSource) {
+        inputSource = &source;
+    }
+    ~InputScope() {
+        inputSource = saved;
     }
+    InputScope(const InputScope&) = delete;
+    InputScope& operator=(const InputScope&) = delete;
+private:
+    InputSource* saved; ///< Источник, который был до подключения
 };
+
 /**
- * @brief Класс для представления вольера.
+ * @brief Трассировка выполнения для просмотра в Perfetto или chrome://tracing (--trace).
+ * @details Каждый поток пишет отрезки (начало и конец области) в свой буфер без блокировок;
+ * мьютекс берётся только при первой записи потока, когда буфер регистрируется. writeJson
+ * переводит буферы в Chrome trace JSON и вызывается, когда потоки уже не пишут: после
+ * WorkStealingPool::wait() или в конце прогона. Пока трассировка не включена, область
+ * стоит одной проверки флага. Названия отрезков и аргументов — строковые литералы.
  */
-class Enclosure {
+class Tracer {
 public:
-    Animal::Climate climate; ///< Климат вольера
-    int capacity;            ///< Вместимость вольера
-    list<Animal> animals;    ///< Список животных в вольере
-    int dailyCost;           ///< Ежедневные расходы на содержание вольера
-    int level;               ///< Уровень вольера
+    static const size_t MAX_SPANS_PER_THREAD = 1 << 20; ///< Дальше отрезки потока отбрасываются
 
     /**
-     * @brief Конструктор для создания нового вольера.
-     * @param c Климат вольера
-     * @param cap Вместимость вольера
+     * @brief Отрезок выполнения.
      */
-    Enclosure(Animal::Climate c, int cap)
-        : climate(c), capacity(cap), level(1) {
-        dailyCost = calculateDailyCost();
+    struct Span {
+        const char* name;    ///< Название области
+        const char* argName; ///< Название аргумента или nullptr
+        int64_t arg;         ///< Значение аргумента
+        uint64_t begin;      ///< Начало, нс от start()
+        uint64_t end;        ///< Конец, нс от start()
+    };
+
+    /**
+     * @brief Общий трассировщик процесса.
+     */
+    static Tracer& instance() {
+        static Tracer tracer;
+        return tracer;
     }
     /**
-     * @brief Проверяет, можно ли добавить животное в вольер.
-     * @param animal Животное для добавления
-     * @return true, если животное можно добавить, иначе false.
+     * @brief Включает трассировку; время отрезков отсчитывается от этого момента.
      */
-    bool canAddAnimal(const Animal& animal) {
-        if (animals.size() >= capacity) return false; // Проверка вместимости
-        if (animal.climate != climate) return false;  // Проверка климата
-
-        // Проверка типа животного
-        if (climate == Animal::OCEAN && !animal.isAquatic()) {
-            cout << "Только водоплавающие животные могут находиться в вольере с климатом 'Океан'!\n";
-            return false;
-        }
-        if (climate != Animal::OCEAN && animal.isAquatic()) {
-            cout << "Водоплавающие животные могут находиться только в вольерах с климатом 'Океан'!\n";
-            return false;
-        }
-
-        // Проверка совместимости хищников и травоядных
-        if (!animals.empty()) {
-            bool hasCarnivore = animals.front().isCarnivore;
-            if (hasCarnivore != animal.isCarnivore) {
-                cout << "Нельзя смешивать хищников и травоядных в одном вольере!\n";
-                return false;
-            }
-        }
-
-        return true;
+    void start() {
+        epoch = chrono::steady_clock::now();
+        on.store(true, memory_order_release);
     }
+    bool enabled() const { return on.load(memory_order_relaxed); }
     /**
-     * @brief Добавляет животное в вольер, если это возможно.
-     * @param animal Животное для добавления
+     * @brief Наносекунды от start().
      */
-    void addAnimal(const Animal& animal) {
-        if (canAddAnimal(animal)) {
-            animals.push_back(animal); //push back добавляет новый эл animal в конец списка (animals - список)
-        }
+    uint64_t now() const {
+        return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - epoch).count();
     }
     /**
-     * @brief Размножает животных в вольере.
-     * @param zoo Ссылка на объект зоопарка
+     * @brief Задаёт имя текущего потока на временной шкале.
      */
-    void breedAnimals(Zoo& zoo) {
-        if (animals.size() < 2) {
-            cout << "Недостаточно животных для размножения!\n";
-            return;
+    static void nameThread(const string& name) {
+        threadName() = name;
+    }
+    /**
+     * @brief Добавляет отрезок в буфер текущего потока.
+     */
+    void record(const Span& span) {
+        ThreadBuffer* buffer = threadBuffer();
+        if (!buffer) buffer = registerThread();
+        if (buffer->spans.size() < MAX_SPANS_PER_THREAD) buffer->spans.push_back(span);
+        else buffer->dropped++;
+    }
+    /**
+     * @brief Записывает все отрезки в формате Chrome trace JSON.
+     * @param path Путь к файлу
+     * @return Отрезков записано.
+     * @throws runtime_error Если файл не создаётся.
+     */
+    uint64_t writeJson(const string& path) const {
+        FILE* file = fopen(path.c_str(), "w");
+        if (!file) throw runtime_error("Не удалось создать файл трассы: " + path);
+        lock_guard<mutex> guard(lock);
+        uint64_t written = 0;
+        fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n", file);
+        fputs("{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"zoo\"}}", file);
+        for (const auto& buffer : buffers) {
+            fprintf(file, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s\"}}",
+                buffer->tid, buffer->name.c_str());
+            for (const Span& span : buffer->spans) {
+                fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f",
+                    span.name, buffer->tid, span.begin / 1e3, (span.end - span.begin) / 1e3);
+                if (span.argName) fprintf(file, ",\"args\":{\"%s\":%lld}", span.argName, static_cast<long long>(span.arg));
+                fputc('}', file);
+                written++;
+            }
         }
+        fputs("\n]}\n", file);
+        fclose(file);
+        return written;
+    }
+    /**
+     * @brief Сколько отрезков отброшено из-за MAX_SPANS_PER_THREAD.
+     */
+    uint64_t dropped() const {
+        lock_guard<mutex> guard(lock);
+        uint64_t total = 0;
+        for (const auto& buffer : buffers) total += buffer->dropped;
+        return total;
+    }
 
-        // Находим разнополую пару
-        Animal* parent1 = nullptr;
-        Animal* parent2 = nullptr;
+private:
+    /**
+     * @brief Буфер отрезков одного потока; пишет в него только сам поток.
+     */
+    struct ThreadBuffer {
+        uint32_t tid;        ///< Номер потока на временной шкале
+        string name;         ///< Имя потока
+        vector<Span> spans;  ///< Отрезки по порядку завершения
+        uint64_t dropped = 0; ///< Отброшено отрезков
+    };
+
+    atomic<bool> on{ false };                   ///< Трассировка включена
+    chrono::steady_clock::time_point epoch;     ///< Начало отсчёта
+    mutable mutex lock;                         ///< Защищает список буферов
+    vector<unique_ptr<ThreadBuffer>> buffers;   ///< Буферы всех потоков; живут дольше потоков
+
+    static ThreadBuffer*& threadBuffer() {
+        thread_local ThreadBuffer* buffer = nullptr;
+        return buffer;
+    }
+    static string& threadName() {
+        thread_local string name;
+        return name;
+    }
+    ThreadBuffer* registerThread() {
+        lock_guard<mutex> guard(lock);
+        auto buffer = make_unique<ThreadBuffer>();
+        buffer->tid = static_cast<uint32_t>(buffers.size()) + 1;
+        buffer->name = threadName().empty() ? "thread " + to_string(buffer->tid) : threadName();
+        buffer->spans.reserve(1 << 12);
+        threadBuffer() = buffer.get();
+        buffers.push_back(move(buffer));
+        return threadBuffer();
+    }
+};
 
-        // Вывод списка животных в вольере
-        cout << "Животные в вольере:\n";
-        int index = 1;
-        for (auto& animal : animals) {
-            cout << index << ". " << animal.name
-                << ", Пол: " << (animal.gender == 'M' ? "М" : "Ж")
-                << ", Возраст: " << animal.ageInDays << " дней\n";
-            index++;
-        }
-
-        // Запрос выбора первого животного
-        int choice1 = getIntegerInput("Введите номер первого животного: ");
-        if (choice1 <= 0 || choice1 > animals.size()) {
-            cout << "Неверный номер первого животного!\n";
-            return;
-        }
-
-        // Запрос выбора второго животного
-        int choice2 = getIntegerInput("Введите номер второго животного: ");
-        if (choice2 <= 0 || choice2 > animals.size() || choice1 == choice2) {
-            cout << "Неверный номер второго животного или вы выбрали одно и то же животное!\n";
-            return;
-        }
-
-        for (auto it1 = animals.begin(); it1 != animals.end(); ++it1) {
-            for (auto it2 = next(it1); it2 != animals.end(); ++it2) {
-                if (it1->gender != it2->gender && it1->ageInDays > 5 && it2->ageInDays > 5) {
-                    parent1 = &(*it1);
-                    parent2 = &(*it2);
-                    break;
-                }
-            }
-            if (parent1 && parent2) break;
-        }
-
-        if (!parent1 || !parent2) {
-            cout << "Не удалось найти подходящую пару для размножения!\n";
-            return;
-        }
-
-        // Выводим информацию о найденной паре
-        cout << "Найдена пара для размножения:\n";
-        cout << "1. " << parent1->name << ", Вид: " << parent1->species << "\n";
-        cout << "2. " << parent2->name << ", Вид: " << parent2->species << "\n";
-
-        // Запрос подтверждения у пользователя
-        cout << "Хотите размножить этих животных?\n";
-        cout << "1. Да\n2. Нет\n";
-        int confirm = getIntegerInput("Ваш выбор: ");
-        if (confirm != 1) {
-            cout << "Размножение отменено.\n";
-            return;
-        }
-
-        // Генерация потомков
-        int offspringCount = rand() % 100 < 10 ? 2 : 1; // 10% шанс на двух потомков
-        offspringCount = min(offspringCount, capacity - static_cast<int>(animals.size())); // Учитываем вместимость вольера
+/**
+ * @brief Отрезок трассировки от создания до конца области видимости.
+ */
+class TraceScope {
+public:
+    /**
+     * @param name Название области (строковый литерал)
+     * @param argName Название аргумента (строковый литерал) или nullptr
+     * @param arg Значение аргумента, например номер дня
+     */
+    explicit TraceScope(const char* name, const char* argName = nullptr, int64_t arg = 0) {
+        Tracer& tracer = Tracer::instance();
+        if (!tracer.enabled()) return;
+        span = { name, argName, arg, tracer.now(), 0 };
+        active = true;
+    }
+    ~TraceScope() {
+        if (!active) return;
+        Tracer& tracer = Tracer::instance();
+        span.end = tracer.now();
+        tracer.record(span);
+    }
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+private:
+    Tracer::Span span;    ///< Отрезок
+    bool active = false;  ///< Трассировка была включена при входе
+};
 
-        if (offspringCount == 0) {
-            cout << "Вольер переполнен! Размножение невозможно.\n";
-            return;
-        }
+#define ZOO_TRACE_SCOPE(...) TraceScope traceScope(__VA_ARGS__)
 
-        for (int i = 0; i < offspringCount; ++i) {
-            try {
-                // Создаем новый вид как комбинацию видов родителей
-                string newSpecies = combineSpecies(parent1->species, parent2->species);
+/**
+ * @brief Фазы дня, которые замеряет профилировщик и отмечает трассировка.
+ */
+enum ProfilePhase {
+    PHASE_EVENTS,      ///< Случайные события
+    PHASE_AGING,       ///< Смерть от старости
+    PHASE_INFECTION,   ///< Заражение случайного животного
+    PHASE_SPREAD,      ///< Распространение вируса
+    PHASE_INCOME,      ///< Популярность, посетители и доход
+    PHASE_PAYROLL,     ///< Зарплаты
+    PHASE_STAFFING,    ///< Распределение животных между сотрудниками
+    PHASE_ENCLOSURES,  ///< Расходы на вольеры
+    PHASE_FEEDING,     ///< Питание и гибель от голода
+    PHASE_COUNT
+};
 
-                // Запрашиваем имя нового животного у пользователя
-                cout << "Введите имя для нового животного (" << newSpecies << "): ";
-                string newName;
-                getline(cin, newName);
+/**
+ * @brief Имена фаз в JSON профиля и на временной шкале трассировки.
+ */
+const char* const PHASE_KEYS[PHASE_COUNT] = { "events", "aging", "infection", "spread",
+    "income", "payroll", "staffing", "enclosures", "feeding" };
 
-                Animal::Type newType = parent1->isAquatic() || parent2->isAquatic() ? Animal::AQUATIC : Animal::LAND;
+#ifdef ZOO_PROFILE
 
-                // Создаем новое животное
-                char newGender = rand() % 2 == 0 ? 'M' : 'F';
-                Animal offspring(
-                    newName,                  // Имя
-                    newSpecies,               // Новый вид
-                    1,                        // Возраст (1 день)
-                    (parent1->weight + parent2->weight) / 2, // Средний вес
-                    parent1->climate,         // Климат
-                    parent1->isCarnivore || parent2->isCarnivore, // Тип питания
-                    newGender,               // Пол
-                    newType,
-                    parent1->name,            // Имя первого родителя
-                    parent2->name             // Имя второго родителя
-                );
+/**
+ * @brief Счётчики событий профилировщика.
+ */
+enum ProfileCounter {
+    COUNTER_DAYS,              ///< Смоделировано дней
+    COUNTER_SCANNED,           ///< Просмотрено строк животных
+    COUNTER_ROLLS,             ///< Вызовов генератора случайных чисел
+    COUNTER_INFECTIONS,        ///< Новых заражений
+    COUNTER_DEATHS_OLD_AGE,    ///< Смертей от старости
+    COUNTER_DEATHS_VIRUS,      ///< Смертей от терановируса
+    COUNTER_DEATHS_STARVATION, ///< Смертей от голода
+    COUNTER_COUNT
+};
 
-                // Добавляем потомка в вольер
-                animals.push_back(offspring);
-                cout << "Рождено новое животное: " << offspring.name
-                    << " (" << (offspring.gender == 'M' ? "М" : "Ж") << "), Вид: " << offspring.species << "\n";
-            }
-            catch (const runtime_error& e) {
-                cout << e.what() << "\n";
-            }
+/**
+ * @brief Накопленные замеры: время и число входов по фазам и счётчики событий.
+ */
+struct PhaseProfile {
+    uint64_t nanoseconds[PHASE_COUNT] = {}; ///< Время в фазах
+    uint64_t calls[PHASE_COUNT] = {};       ///< Входов в фазы
+    uint64_t counters[COUNTER_COUNT] = {};  ///< Счётчики событий
+
+    PhaseProfile& operator+=(const PhaseProfile& other) {
+        for (int i = 0; i < PHASE_COUNT; ++i) {
+            nanoseconds[i] += other.nanoseconds[i];
+            calls[i] += other.calls[i];
         }
+        for (int i = 0; i < COUNTER_COUNT; ++i) counters[i] += other.counters[i];
+        return *this;
     }
     /**
-     * @brief Удаляет животное из вольера по имени.
-     * @param name Имя животного для удаления
+     * @brief Печатает замеры таблицей.
      */
-    void removeAnimal(const string& name) {
-        for (auto it = animals.begin(); it != animals.end(); ++it) { //Создаём итератор It который прохожит по всему списку
-            if (it->name == name) {
-                animals.erase(it);
-                return;
-            }
+    void printTable(ostream& out) const {
+        static const char* PHASE_LABELS[PHASE_COUNT] = { "События", "Старость", "Заражение", "Вирус",
+            "Доход", "Зарплаты", "Сотрудники", "Вольеры", "Питание" };
+        static const char* COUNTER_LABELS[COUNTER_COUNT] = { "Дней", "Просмотрено животных",
+            "Случайных чисел", "Заражений", "Умерло от старости", "Умерло от вируса", "Умерло от голода" };
+        uint64_t total = 0;
+        for (uint64_t ns : nanoseconds) total += ns;
+        out << "=== Профиль дня ===\n";
+        out << "Фаза            Вызовов      Всего, мс  Среднее, мкс   Доля\n";
+        for (int i = 0; i < PHASE_COUNT; ++i) {
+            // Ширина по символам, а не байтам: названия в UTF-8
+            string label = PHASE_LABELS[i];
+            size_t width = count_if(label.begin(), label.end(), [](char c) { return (c & 0xC0) != 0x80; });
+            label.append(width < 12 ? 12 - width : 0, ' ');
+            char line[128];
+            snprintf(line, sizeof(line), "%s %10llu %14.3f %13.3f %5.1f%%\n", label.c_str(),
+                static_cast<unsigned long long>(calls[i]), nanoseconds[i] / 1e6,
+                calls[i] ? nanoseconds[i] / 1e3 / calls[i] : 0.0, total ? 100.0 * nanoseconds[i] / total : 0.0);
+            out << line;
+        }
+        for (int i = 0; i < COUNTER_COUNT; ++i) {
+            out << COUNTER_LABELS[i] << ": " << counters[i] << "\n";
         }
     }
     /**
-     * @brief Заражает случайное животное в вольере.
+     * @brief Печатает замеры одним объектом JSON.
      */
-    void infectRandomAnimal() {
-        if (animals.empty()) return; // Если в вольере нет животных, ничего не делаем
-
-        for (auto& animal : animals) {
-            if (!animal.isInfected && rand() % 100 < 30) { // 30% шанс заражения
-                animal.isInfected = true;
-                cout << "Животное \"" << animal.name << "\" заразилось терановирусом!\n";
-                return; // Заражаем только одно животное за раз
-            }
+    void printJson(ostream& out) const {
+        static const char* COUNTER_KEYS[COUNTER_COUNT] = { "days", "animals_scanned", "rng_calls",
+            "infections", "deaths_old_age", "deaths_virus", "deaths_starvation" };
+        out << "{\"phases\":{";
+        for (int i = 0; i < PHASE_COUNT; ++i) {
+            out << (i ? "," : "") << "\"" << PHASE_KEYS[i] << "\":{\"calls\":" << calls[i]
+                << ",\"ns\":" << nanoseconds[i] << "}";
         }
-    }
-    /**
-    * @brief Распространяет вирус среди животных в вольере.
-    */
-    void spreadVirus() {
-        int infectedCount = 0;
-        for (auto& animal : animals) {
-            if (animal.isInfected) infectedCount++;
+        out << "},\"counters\":{";
+        for (int i = 0; i < COUNTER_COUNT; ++i) {
+            out << (i ? "," : "") << "\"" << COUNTER_KEYS[i] << "\":" << counters[i];
         }
+        out << "}}\n";
+    }
+};
 
-        if (infectedCount > animals.size() / 2) {
-            // Если больше половины животных заражены, начинают умирать
-            vector<string> deadAnimals;
-            for (auto it = animals.begin(); it != animals.end() && infectedCount > animals.size() / 2;) {
-                if (it->isInfected && rand() % 2 == 0) {
-                    deadAnimals.push_back(it->name);
-                    it = animals.erase(it);
-                    infectedCount--;
-                }
-                else {
-                    ++it;
-                }
-            }
+/**
+ * @brief Замеры текущего потока выполнения; параллельные прогоны сливают их по окончании.
+ */
+thread_local PhaseProfile threadProfile;
 
-            // Вывод уведомлений о смерти
-            if (!deadAnimals.empty()) {
-                cout << "\n--- Уведомления ---\n";
-                for (const string& name : deadAnimals) {
-                    cout << "Животное \"" << name << "\" умерло от терановируса.\n";
-                }
+/**
+ * @brief Замеряет время от создания до конца области видимости и относит его к фазе.
+ */
+class ProfileScope {
+public:
+    explicit ProfileScope(ProfilePhase p) : phase(p), start(chrono::steady_clock::now()) {}
+    ~ProfileScope() {
+        auto elapsed = chrono::steady_clock::now() - start;
+        threadProfile.nanoseconds[phase] += chrono::duration_cast<chrono::nanoseconds>(elapsed).count();
+        threadProfile.calls[phase]++;
+    }
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+private:
+    ProfilePhase phase;                       ///< Фаза
+    chrono::steady_clock::time_point start;   ///< Начало замера
+};
+
+// Фаза дня: замер профиля и отрезок трассировки (если она включена)
+#define ZOO_PROFILE_PHASE(phase) ProfileScope profileScope(phase); ZOO_TRACE_SCOPE(PHASE_KEYS[phase])
+#define ZOO_COUNT(counter, n) (threadProfile.counters[counter] += static_cast<uint64_t>(n))
+#else
+// Без ZOO_PROFILE замеры профиля не компилируются вовсе; остаётся только отрезок трассировки
+#define ZOO_PROFILE_PHASE(phase) ZOO_TRACE_SCOPE(PHASE_KEYS[phase])
+#define ZOO_COUNT(counter, n) ((void)0)
+#endif
+
+// Функция для разделения строки на слова
+vector<string> splitString(const string& str) {
+    vector<string> words;
+    string word;
+    for (char c : str) {
+        if (c == ' ') {
+            if (!word.empty()) {
+                words.push_back(word);
+                word.clear();
             }
         }
         else {
-            // Иначе каждое больное животное заражает ещё двух
-            for (auto& animal : animals) {
-                if (animal.isInfected) {
-                    int infections = 0;
-                    for (auto it = animals.begin(); it != animals.end() && infections < 2; ++it) {
-                        if (!it->isInfected && rand() % 100 < 30) { // 30% шанс заражения
-                            it->isInfected = true;
-                            infections++;
-                            cout << "Животное \"" << it->name << "\" заразилось терановирусом!\n";
-                        }
-                    }
-                }
-            }
+            word += c;
         }
     }
-    /**
-    * @brief Улучшает вольер до следующего уровня.
-    * @param baseUpgradeCost Базовая стоимость улучшения
-    * @return true, если улучшение успешно, иначе false.
-    */
-    bool upgrade(int baseUpgradeCost) {
-        if (level >= 3) { // Ограничение на максимальный уровень
-            cout << "Достигнут максимальный уровень улучшения!\n";
-            return false;
-        }
-        capacity *= 2; // Увеличиваем вместимость в два раза
-        dailyCost += calculateDailyCost() / 2; // Увеличиваем ежедневные расходы
-        level++; // Повышаем уровень
-        return true;
+    if (!word.empty()) {
+        words.push_back(word);
     }
-    /**
-     * @brief Рассчитывает стоимость строительства вольера.
-     * @return Стоимость вольера в монетах.
-     */
-    int calculateCost() const {
-        int baseCost = 100; // Базовая стоимость
-        int cost = baseCost;
+    return words;
+}
 
-        // Модификаторы стоимости:
-        cost += capacity * 10; // Чем больше вместимость, тем дороже
-        cost += static_cast<int>(climate) * 50; // Разные климаты влияют на стоимость
+/**
+ * @brief Список видов животных для климата пустыни.
+ */
+const string DESERT_SPECIES[] = { "Песчаный дракон", "Каменный скорпион", "Солнечный ящер", "Пустынный волк", "Гигантский скорпион" };
+/**
+ * @brief Список видов животных для климата леса.
+ */
+const string FOREST_SPECIES[] = { "Лесной феникс", "Теневой олень", "Кристальный медведь", "Искрящийся лис", "Механический единорог" };
+/**
+ * @brief Список видов животных для климата арктики.
+ */
+const string ARCTIC_SPECIES[] = { "Ледяной медведь", "Снежный дракон", "Арктический волк", "Хрустальная рыба", "Ледяной орёл" };
+/**
+ * @brief Список видов животных для климата океана.
+ */
+const string OCEAN_SPECIES[] = { "Глубинный кракен", "Электрическая акула", "Морской дракон", "Водяной дух", "Океанический гигант" };
 
-        return max(cost, 150); // Минимальная стоимость = 150
+/**
+ * @brief Компактный идентификатор вида в таблице SpeciesTable.
+ */
+using SpeciesId = uint16_t;
+
+/**
+ * @brief Таблица интернированных видов животных.
+ * @details Каждое название вида хранится один раз, животные ссылаются на него по SpeciesId.
+ * Названия заранее разбиты на слова, а гибриды ищутся в хеш-таблице по паре слов,
+ * поэтому при размножении строки создаются только для ещё не встречавшихся гибридов.
+ * Таблица общая для всех зоопарков и только растёт.
+ */
+class SpeciesTable {
+public:
+    /**
+     * @brief Возвращает общую таблицу видов.
+     * @details Чтение из нескольких потоков безопасно, пока никто не добавляет виды;
+     * параллельные прогоны поэтому регистрируют все виды до запуска.
+     */
+    static SpeciesTable& instance() {
+        static SpeciesTable table;
+        return table;
     }
     /**
-     * @brief Рассчитывает ежедневные расходы на содержание вольера.
-     * @return Ежедневные расходы в монетах.
+     * @brief Возвращает идентификатор вида, добавляя его в таблицу при необходимости.
+     * @param name Название вида
+     * @return Идентификатор вида.
+     * @throws runtime_error Если таблица переполнена.
      */
-    int calculateDailyCost() const {
-        int baseDailyCost = 10; // Базовые ежедневные расходы
-        int dailyCost = baseDailyCost;
-
-        // Модификаторы расходов:
-        dailyCost += capacity / 10; // Большая вместимость увеличивает расходы
-        dailyCost += static_cast<int>(climate) * 5; // Разные климаты влияют на расходы
+    SpeciesId intern(const string& name) {
+        auto found = speciesIndex.find(name);
+        if (found != speciesIndex.end()) return found->second;
+        if (entries.size() > numeric_limits<SpeciesId>::max()) {
+            throw runtime_error("Слишком много видов животных.");
+        }
 
-        // Учет водоплавающих животных
-        for (const auto& animal : animals) {
-            if (animal.isAquatic()) {
-                dailyCost += 10; // Дополнительные расходы за каждое водоплавающее животное
-            }
+        Entry entry;
+        entry.name = name;
+        entry.firstWord = static_cast<uint32_t>(wordsOfSpecies.size());
+        for (const string& word : splitString(name)) {
+            wordsOfSpecies.push_back(internWord(word));
         }
+        entry.wordCount = static_cast<uint32_t>(wordsOfSpecies.size()) - entry.firstWord;
 
-        return max(dailyCost, 10); // Минимальные расходы = 10
+        SpeciesId id = static_cast<SpeciesId>(entries.size());
+        entries.push_back(move(entry));
+        speciesIndex.emplace(name, id);
+        return id;
     }
-};
-/**
- * @brief Класс для представления сотрудника зоопарка.
- */
-class Employee {
-public:
-    string name;         ///< Имя сотрудника
-    string position;     ///< Должность сотрудника
-    int salary;          ///< Зарплата сотрудника
-    int maxAnimals;      ///< Максимальное количество животных, за которыми может ухаживать сотрудник
-    int currentAnimals;  ///< Текущее количество животных, за которыми ухаживает сотрудник
     /**
-     * @brief Конструктор для создания нового сотрудника.
-     * @param n Имя сотрудника
-     * @param pos Должность
-     * @param sal Зарплата
-     * @param max Максимальное количество животных
+     * @brief Название вида.
+     * @param id Идентификатор вида
      */
-    Employee(string n, string pos, int sal, int max)
-        : name(n), position(pos), salary(sal), maxAnimals(max), currentAnimals(0) {}
+    const string& name(SpeciesId id) const {
+        return entries[id].name;
+    }
+    /**
+     * @brief Количество слов в названии вида.
+     */
+    uint32_t wordCount(SpeciesId id) const {
+        return entries[id].wordCount;
+    }
+    /**
+     * @brief Идентификатор i-го слова в названии вида.
+     */
+    uint32_t word(SpeciesId id, uint32_t i) const {
+        return wordsOfSpecies[entries[id].firstWord + i];
+    }
+    /**
+     * @brief Находит или создаёт гибридный вид из двух слов.
+     * @param word1 Идентификатор первого слова
+     * @param word2 Идентификатор второго слова
+     * @return Идентификатор гибридного вида.
+     */
+    SpeciesId hybrid(uint32_t word1, uint32_t word2) {
+        uint64_t key = (static_cast<uint64_t>(word1) << 32) | word2;
+        auto found = hybrids.find(key);
+        if (found != hybrids.end()) return found->second;
+        SpeciesId id = intern(words[word1] + " " + words[word2]);
+        hybrids.emplace(key, id);
+        return id;
+    }
+    /**
+     * @brief Базовые виды климата.
+     * @param climate Номер климата (Animal::Climate)
+     */
+    const vector<SpeciesId>& byClimate(int climate) const {
+        return climateSpecies[climate];
+    }
+    /**
+     * @brief Идентификатор вида-заглушки для неизвестного климата.
+     */
+    SpeciesId unknown() const {
+        return unknownSpecies;
+    }
+    /**
+     * @brief Количество видов в таблице.
+     */
+    size_t size() const {
+        return entries.size();
+    }
+
+private:
+    /**
+     * @brief Запись о виде.
+     */
+    struct Entry {
+        string name;         ///< Название вида
+        uint32_t firstWord;  ///< Начало слов вида в wordsOfSpecies
+        uint32_t wordCount;  ///< Количество слов
+    };
+
+    vector<Entry> entries;                        ///< Виды по идентификатору
+    unordered_map<string, SpeciesId> speciesIndex; ///< Поиск вида по названию
+    vector<uint32_t> wordsOfSpecies;              ///< Слова всех видов подряд
+    vector<string> words;                         ///< Словарь слов
+    unordered_map<string, uint32_t> wordIndex;    ///< Поиск слова
+    unordered_map<uint64_t, SpeciesId> hybrids;   ///< Гибриды по паре слов
+    vector<SpeciesId> climateSpecies[4];          ///< Базовые виды по климатам
+    SpeciesId unknownSpecies;                     ///< Вид-заглушка
+
+    SpeciesTable() {
+        for (const string& s : DESERT_SPECIES) climateSpecies[0].push_back(intern(s));
+        for (const string& s : FOREST_SPECIES) climateSpecies[1].push_back(intern(s));
+        for (const string& s : ARCTIC_SPECIES) climateSpecies[2].push_back(intern(s));
+        for (const string& s : OCEAN_SPECIES) climateSpecies[3].push_back(intern(s));
+        unknownSpecies = intern("Неизвестный вид");
+    }
+
+    uint32_t internWord(const string& word) {
+        auto found = wordIndex.find(word);
+        if (found != wordIndex.end()) return found->second;
+        uint32_t id = static_cast<uint32_t>(words.size());
+        words.push_back(word);
+        wordIndex.emplace(word, id);
+        return id;
+    }
 };
-/**
- * @brief Генерирует случайное животное.
- * @return Случайное животное.
- */
-Animal generateRandomAnimal(); // Предварительное объявление функции
 
 /**
- * @brief Класс для представления зоопарка.
+ * @brief Счётчиковый генератор случайных чисел.
+ * @details Очередное значение — хеш SplitMix64 от пары (ключ потока, номер вызова),
+ * поэтому генераторы с разными ключами дают независимые потоки, а всё состояние
+ * генератора — два числа. Зоопарк выдаёт отдельный поток каждой подсистеме и каждому
+ * вольеру, так что результат не зависит от порядка обработки вольеров.
  */
-class Zoo {
+class Rng {
 public:
-    string name;                     ///< Название зоопарка
-    int money, food, popularity;     ///< Деньги, количество еды и популярность зоопарка
-    int day;                         ///< Текущий день
-    int animalsBoughtToday;          ///< Счётчик купленных сегодня животных
-    list<Enclosure> enclosures;      ///< Список вольеров 
-    list<Employee> employees;        ///< Список сотрудников
-    vector<Animal> animalMarket;     ///< Пул животных для покупки
+    uint64_t key;      ///< Ключ потока
+    uint64_t counter;  ///< Номер следующего вызова
+
+    explicit Rng(uint64_t k = 0) : key(k), counter(0) {}
+
     /**
-     * @brief Конструктор для создания нового зоопарка.
-     * @param n Название зоопарка
-     * @param initialMoney Начальный капитал
+     * @brief Перемешивающая функция SplitMix64.
      */
-    Zoo(string n, int initialMoney)
-        : name(n), money(initialMoney), food(0), popularity(50), day(1) {
-        generateAnimalMarket(); // Инициализация пула животных
+    static uint64_t mix(uint64_t z) {
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
     }
     /**
-     * @brief Генерирует пул животных для покупки.
+     * @brief Создаёт генератор для подпотока.
+     * @param seed Зерно зоопарка
+     * @param stream Номер подсистемы
+     * @param sub Номер подпотока внутри подсистемы (например, номер вольера)
      */
-    void generateAnimalMarket() {
-        const int MAX_ANIMALS_IN_MARKET = 10;
-        animalMarket.clear();
-        for (int i = 0; i < MAX_ANIMALS_IN_MARKET; ++i) {
-            animalMarket.push_back(generateRandomAnimal());
-        }
+    static Rng stream(uint64_t seed, uint32_t stream, uint32_t sub = 0) {
+        return Rng(mix(mix(seed) ^ ((static_cast<uint64_t>(stream) << 32) | sub)));
     }
     /**
-     * @brief Сброс счётчика купленных животных за текущий день.
+     * @brief Следующее 64-битное значение.
      */
-    void resetDailyCounters() {
-        animalsBoughtToday = 0; // Сбрасываем счетчик в начале дня
+    uint64_t next() {
+        ZOO_COUNT(COUNTER_ROLLS, 1);
+        return mix(key + ++counter * 0x9E3779B97F4A7C15ULL);
     }
     /**
-     * @brief Список событий за текущий день.
+     * @brief Равномерное целое в диапазоне [0, n).
      */
-    vector<string> dailyEvents; // Список событий за текущий день
+    uint32_t below(uint32_t n) {
+        return static_cast<uint32_t>(((next() >> 32) * n) >> 32);
+    }
     /**
-     * @brief Добавляем события.
+     * @brief Равномерное вещественное число в диапазоне [0, 1).
      */
-    void addEvent(const string& event) {
-        dailyEvents.push_back(event);
+    double uniform() {
+        return static_cast<double>(next() >> 11) * (1.0 / 9007199254740992.0); // 2^-53
     }
     /**
-     * @brief Обновляет пул животных.
-     * @param day Текущий день
+     * @brief Событие с вероятностью percent%.
      */
-    void refreshAnimalMarket(int day) {
-        if (day > 10 && animalMarket.size() >= 1) {
-            cout << "После 10 дня можно обновить рынок только за плату!\n";
-            int refreshCost = 150; // Стоимость обновления рынка
-            if (money < refreshCost) {
-                cout << "Недостаточно средств для обновления рынка!\n";
-                return;
-            }
-            money -= refreshCost;
+    bool chance(int percent) {
+        return static_cast<int>(below(100)) < percent;
+    }
+};
+
+/**
+ * @brief Накопитель 64-битного хеша FNV-1a для сверки состояний.
+ */
+class StateHash {
+public:
+    uint64_t value = 1469598103934665603ULL; ///< Текущее значение хеша
+
+    void addBytes(const void* data, size_t n) {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < n; ++i) {
+            value = (value ^ bytes[i]) * 1099511628211ULL;
         }
-        generateAnimalMarket();
-        cout << "Рынок животных обновлен!\n";
     }
-    /**
- * @brief Переходит к следующему дню в зоопарке.
- * @details Обрабатывает заражение животных, распространение вируса,
- * уменьшение популярности и расчет дохода, а также случайные события.
- */
-    void nextDay() {
-        cout << "\n--- День " << day << " ---\n";
-
-        // Бюджет до дня
-        cout << "Бюджет прошлого дня: " << money << " монет\n";
-
-        dailyEvents.clear();
-
-        resetDailyCounters();
-
-        processRandomEvents();
-
-
-        // Увеличение возраста животных и проверка смерти от старости
-        for (auto& enc : enclosures) {
-            for (auto it = enc.animals.begin(); it != enc.animals.end();) {
-                it->growOlder(); // Увеличиваем возраст животного
-                if (it->diesOfOldAge()) {
-                    cout << "Животное \"" << it->name << "\" умерло от старости.\n";
-                    it = enc.animals.erase(it); // Удаляем животное из списка
-                }
-                else {
-                    ++it;
-                }
-            }
-        }
-
-        // Заражение случайного животного
-        for (auto& enc : enclosures) {
-            enc.infectRandomAnimal();
-        }
+    template <typename T>
+    void add(const T& v) {
+        static_assert(is_trivially_copyable<T>::value, "Побайтно хешируются только простые значения");
+        addBytes(&v, sizeof(v));
+    }
+    template <typename T>
+    void add(const vector<T>& v) {
+        add(v.size());
+        addBytes(v.data(), v.size() * sizeof(T));
+    }
+    void add(const string& s) {
+        add(s.size());
+        addBytes(s.data(), s.size());
+    }
+};
 
-        // Распространение вируса
-        for (auto& enc : enclosures) {
-            enc.spreadVirus();
+/**
+ * @brief Запись двоичного снимка зоопарка.
+ * @details Числа пишутся в порядке байтов машины. Массивы выравниваются по 8 байтам
+ * от начала файла, чтобы при загрузке их можно было взять прямо из отображённого файла.
+ */
+class SnapshotWriter {
+public:
+    /**
+     * @param path Путь к файлу; снимок пишется рядом во временный файл и заменяет
+     * прежний только в finish, так что оборванная запись не портит последний снимок
+     * @throws runtime_error Если файл не открывается.
+     */
+    explicit SnapshotWriter(const string& path) : path(path), out(path + ".tmp", ios::binary) {
+        if (!out) throw runtime_error("Не удалось создать файл снимка: " + path);
+    }
+    /**
+     * @brief Записывает значение простого типа как есть.
+     */
+    template <typename T>
+    void pod(const T& value) {
+        write(&value, sizeof(value));
+    }
+    /**
+     * @brief Записывает строку: длину и байты.
+     */
+    void str(const string& s) {
+        pod(static_cast<uint64_t>(s.size()));
+        write(s.data(), s.size());
+    }
+    /**
+     * @brief Записывает массив: длину и выровненные элементы.
+     */
+    template <typename T>
+    void array(const vector<T>& v) {
+        pod(static_cast<uint64_t>(v.size()));
+        static const char zeros[8] = {};
+        write(zeros, (8 - offset % 8) % 8);
+        write(v.data(), v.size() * sizeof(T));
+    }
+    /**
+     * @brief Записывает массив, хранящийся частями, так же, как array() записал бы его целиком.
+     * @param parts Части по порядку (например, vector<SharedColumn<T>>)
+     */
+    template <typename Parts>
+    void chunkedArray(const Parts& parts) {
+        uint64_t total = 0;
+        for (const auto& part : parts) total += part.size();
+        pod(total);
+        static const char zeros[8] = {};
+        write(zeros, (8 - offset % 8) % 8);
+        for (const auto& part : parts) write(part.data(), part.size() * sizeof(part[0]));
+    }
+    /**
+     * @brief Дописывает файл на диск.
+     * @throws runtime_error Если запись не удалась.
+     */
+    void finish() {
+        out.close();
+        if (!out) throw runtime_error("Не удалось записать снимок: " + path);
+#ifdef _WIN32
+        remove(path.c_str()); // rename в Windows не заменяет существующий файл
+#endif
+        // В POSIX rename атомарно заменяет прежний снимок: сбой не оставит каталог без него
+        if (rename((path + ".tmp").c_str(), path.c_str()) != 0) {
+            throw runtime_error("Не удалось записать снимок: " + path);
         }
+    }
 
-        // Уменьшение популярности из-за больных животных
-        int infectedCount = 0;
-        for (auto& enc : enclosures) {
-            for (auto& animal : enc.animals) {
-                if (animal.isInfected) infectedCount++;
-            }
-        }
-        popularity -= infectedCount;
-        popularity = max(popularity, 0);
+private:
+    string path;       ///< Итоговый путь снимка
+    ofstream out;      ///< Временный файл снимка
+    size_t offset = 0; ///< Записано байт
 
-        // Рассчет посетителей и дохода
-        int visitors = 2 * popularity;
-        int totalAnimals = getTotalAnimals();
-        int income = visitors * totalAnimals;
-        cout << "Посетители сегодня: " << visitors << "\n";
-        cout << "Доход за день: +" << income << " монет\n";
+    void write(const void* data, size_t n) {
+        out.write(static_cast<const char*>(data), static_cast<streamsize>(n));
+        offset += n;
+    }
+};
 
-        // Добавляем доход к бюджету
-        money += income;
+/**
+ * @brief Чтение двоичного снимка из памяти (обычно из отображённого файла).
+ * @details Массивы берутся из памяти целиком, без разбора по записям.
+ * Любой выход за конец данных — ошибка: снимок обрезан или повреждён.
+ */
+class SnapshotReader {
+public:
+    /**
+     * @param data Начало снимка (выровнено хотя бы по 8 байтам)
+     * @param size Размер снимка в байтах
+     */
+    SnapshotReader(const char* data, size_t size) : data(data), size(size) {}
+
+    template <typename T>
+    void pod(T& value) {
+        static_assert(is_trivially_copyable<T>::value, "pod() читает только тривиально копируемые типы");
+        need(sizeof(T));
+        memcpy(&value, data + pos, sizeof(T));
+        pos += sizeof(T);
+    }
+    template <typename T>
+    T pod() {
+        T value;
+        pod(value);
+        return value;
+    }
+    string str() {
+        uint64_t n = pod<uint64_t>();
+        need(n);
+        string s(data + pos, static_cast<size_t>(n));
+        pos += static_cast<size_t>(n);
+        return s;
+    }
+    template <typename T>
+    void array(vector<T>& v) {
+        uint64_t n = pod<uint64_t>();
+        need((8 - pos % 8) % 8);
+        pos += (8 - pos % 8) % 8;
+        if (n > (size - pos) / sizeof(T)) throw runtime_error("Снимок обрезан или повреждён");
+        const T* first = reinterpret_cast<const T*>(data + pos);
+        v.assign(first, first + n);
+        pos += static_cast<size_t>(n) * sizeof(T);
+    }
 
-        // Зарплаты сотрудникам
-        for (auto& emp : employees) {
-            money -= emp.salary; // Вычитаем зарплату из всех денег
-            emp.currentAnimals = 0; // Сброс счетчика
+    /**
+     * @brief Читает массив, записанный array(), частями по chunkSize элементов.
+     * @param parts Части (например, vector<SharedColumn<T>>); прежнее содержимое заменяется
+     * @param chunkSize Элементов в части
+     * @return Всего элементов.
+     */
+    template <typename Parts>
+    size_t chunkedArray(Parts& parts, size_t chunkSize) {
+        using Item = typename remove_reference_t<decltype(parts.emplace_back().edit())>::value_type;
+        parts.clear();
+        uint64_t n = pod<uint64_t>();
+        need((8 - pos % 8) % 8);
+        pos += (8 - pos % 8) % 8;
+        if (n > (size - pos) / sizeof(Item)) throw runtime_error("Снимок обрезан или повреждён");
+        const Item* first = reinterpret_cast<const Item*>(data + pos);
+        for (size_t done = 0; done < n; done += chunkSize) {
+            parts.emplace_back().edit().assign(first + done, first + min<size_t>(n, done + chunkSize));
         }
+        pos += static_cast<size_t>(n) * sizeof(Item);
+        return static_cast<size_t>(n);
+    }
 
-        // Распределение животных между сотрудниками
-        for (auto& enc : enclosures) { // Перебираем вольеры
-            for (auto& emp : employees) { // Перебираем сотрудников
-                if (emp.currentAnimals < emp.maxAnimals) {
-                    int canTake = emp.maxAnimals - emp.currentAnimals;
-                    int animalsInEnclosure = enc.animals.size(); // Определяем количество животных в вольере
-                    int assignCount = min(canTake, animalsInEnclosure);
-                    emp.currentAnimals += assignCount; // Обновляем счётчик
-                    if (emp.currentAnimals >= emp.maxAnimals) break;
-                }
-            }
-        }
+private:
+    const char* data; ///< Начало снимка
+    size_t size;      ///< Размер снимка
+    size_t pos = 0;   ///< Позиция чтения
 
-        // Расходы на вольеры
-        for (auto& enc : enclosures) {
-            money -= enc.dailyCost;
-        }
+    void need(uint64_t n) const {
+        if (n > size - pos) throw runtime_error("Снимок обрезан или повреждён");
+    }
+};
 
-        // Питание животных
-        int requiredFood = totalAnimals; // Количество еды, необходимое для всех животных
-        vector<string> deadAnimals; // Список умерших животных
-        if (food >= requiredFood) {
-            food -= requiredFood;
-            money -= requiredFood * 2; // Каждый кг еды стоит 2 монеты
-        }
-        else {
-            int deficit = requiredFood - food; // Считаем сколько животных останутся голодными
-            for (auto& enc : enclosures) { // Перебираем животных и со случайным шансом они умирают
-                for (auto it = enc.animals.begin(); it != enc.animals.end() && deficit > 0;) {
-                    if (rand() % 2 == 0) {
-                        deadAnimals.push_back(it->name); // Сохраняем имя умершего животного
-                        it = enc.animals.erase(it);
-                        deficit--;
-                    }
-                    else {
-                        ++it;
-                    }
-                }
-            }
-            food = 0;
+/**
+ * @brief Файл, отображённый в память только для чтения.
+ * @details На системах без mmap файл читается в память целиком.
+ */
+class MappedFile {
+public:
+    /**
+     * @param path Путь к файлу
+     * @throws runtime_error Если файл не открывается.
+     */
+    explicit MappedFile(const string& path) {
+#ifdef _WIN32
+        ifstream in(path, ios::binary);
+        if (!in) throw runtime_error("Не удалось открыть файл: " + path);
+        buffer.assign(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+        base = buffer.data();
+        length = buffer.size();
+#else
+        int fd = open(path.c_str(), O_RDONLY);
+        struct stat info;
+        if (fd < 0 || fstat(fd, &info) != 0) {
+            if (fd >= 0) ::close(fd);
+            throw runtime_error("Не удалось открыть файл: " + path);
         }
+        length = static_cast<size_t>(info.st_size);
+        void* mapping = length ? mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0) : nullptr;
+        ::close(fd);
+        if (mapping == MAP_FAILED) throw runtime_error("Не удалось отобразить файл в память: " + path);
+        if (mapping) madvise(mapping, length, MADV_SEQUENTIAL);
+        base = static_cast<const char*>(mapping);
+#endif
+    }
+    ~MappedFile() {
+#ifndef _WIN32
+        if (base) munmap(const_cast<char*>(base), length);
+#endif
+    }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* data() const { return base; }
+    size_t size() const { return length; }
+
+private:
+    const char* base = nullptr; ///< Начало данных
+    size_t length = 0;          ///< Размер файла
+#ifdef _WIN32
+    vector<char> buffer;        ///< Содержимое файла
+#endif
+};
 
-        // Колебания популярности
-        int fluctuation = popularity * 0.1;
-        int change = (rand() % (2 * fluctuation + 1)) - fluctuation;
-        popularity += change;
-        popularity = max(popularity, 0);
+/**
+ * @brief Номера подсистем для Rng::stream.
+ */
+enum RngStream : uint32_t {
+    RNG_EVENTS,      ///< Случайные события
+    RNG_MARKET,      ///< Рынок животных
+    RNG_FEEDING,     ///< Голод
+    RNG_POPULARITY,  ///< Колебания популярности
+    RNG_BREEDING,    ///< Размножение
+    RNG_AGING,       ///< Смерть от старости (по вольерам)
+    RNG_INFECTION,   ///< Заражение случайного животного (по вольерам)
+    RNG_SPREAD,      ///< Распространение вируса (по вольерам)
+    RNG_GENERATOR,   ///< Генератор больших зоопарков (по вольерам, см. generateZoo)
+    RNG_FORK         ///< Зёрна развилок (по номеру развилки, см. Zoo::fork)
+};
 
-        // Бюджет после дня
-        cout << "Бюджет текущего дня: " << money << " монет\n";
+// Функция для комбинирования видов
+SpeciesId combineSpecies(SpeciesId species1, SpeciesId species2, Rng& rng) {
+    SpeciesTable& table = SpeciesTable::instance();
 
-        // Уведомления о смерти животных
-        if (!deadAnimals.empty()) {
-            cout << "\n--- Уведомления ---\n";
-            for (const string& name : deadAnimals) {
-                cout << "Животное \"" << name << "\" умерло от голода.\n";
-            }
-        }
+    // Выбираем случайное слово из первого вида
+    uint32_t part1 = table.word(species1, rng.below(table.wordCount(species1)));
 
-        // Проверка банкротства
-        if (money < 0) {
-            cout << "\nБАНКРОТСТВО! Вы проиграли.\n";
-            exit(0); // Завершаем игру
-        }
+    // Выбираем случайное слово из второго вида
+    uint32_t part2 = table.word(species2, rng.below(table.wordCount(species2)));
 
-        // Увеличение дня
-        day++; // Переход к следующему дню
-    }
+    // Находим или собираем новый вид
+    return table.hybrid(part1, part2);
+}
+/**
+ * @brief Дескриптор животного.
+ * @details Младшие 24 бита — индекс слота в AnimalRegistry, старшие 8 бит — поколение слота.
+ * Нулевой дескриптор никогда не выдаётся и означает "нет животного".
+ */
+using AnimalId = uint32_t;
+const AnimalId NO_ANIMAL = 0; ///< Пустой дескриптор
 
-    // Метод для обработки случайных событий
-    void processRandomEvents() {
-        const int EVENT_PROBABILITY = 20; // 20% вероятность события
+/**
+ * @brief Массив с копированием при записи: копии разделяют данные, пока одна из них не изменит их.
+ * @details Чтение идёт через константный интерфейс, изменение — только через edit(), который
+ * сначала делает данные собственными, если их кто-то разделяет. Так развилки зоопарка
+ * (Zoo::fork) копируют лишь те столбцы, которые меняют. Копии можно менять из разных
+ * потоков, пока исходный зоопарк жив и сам не меняется.
+ */
+template <typename T>
+class SharedColumn {
+public:
+    using const_iterator = typename vector<T>::const_iterator;
+
+    const T& operator[](size_t i) const { return (*column)[i]; }
+    size_t size() const { return column->size(); }
+    bool empty() const { return column->empty(); }
+    size_t capacity() const { return column->capacity(); }
+    const T* data() const { return column->data(); }
+    const_iterator begin() const { return column->begin(); }
+    const_iterator end() const { return column->end(); }
+    /**
+     * @brief Данные только для чтения.
+     */
+    const vector<T>& values() const { return *column; }
+    /**
+     * @brief Данные для изменения; разделяемые данные сначала копируются.
+     */
+    vector<T>& edit() {
+        if (column.use_count() > 1) column = make_shared<vector<T>>(*column);
+        return *column;
+    }
+    /**
+     * @brief Очищает массив; разделяемые данные не копируются, а отпускаются.
+     */
+    void clear() {
+        if (column.use_count() > 1) column = make_shared<vector<T>>();
+        else column->clear();
+    }
+    /**
+     * @brief Разделяет ли массив данные с другой копией.
+     */
+    bool shared() const { return column.use_count() > 1; }
 
-        // Положительные события
-        vector<pair<string, function<void()>>> positiveEvents = {
-            {"Знаменитый посетитель", [this]() {
-                popularity += 10;
-                cout << "Знаменитый посетитель: Популярность увеличена на 10.\n";
-                addEvent("Знаменитый посетитель: Популярность увеличена на 10.");
-            }},
-            {"Пожертвование от спонсора", [this]() {
-                money += 500;
-                cout << "Пожертвование от спонсора: Получено 500 монет.\n";
-                addEvent("Пожертвование от спонсора: Получено 500 монет.");
-            }},
-            {"Редкий гость", [this]() {
-                popularity += 5;
-                cout << "Редкий гость: Популярность увеличена на 5.\n";
-                addEvent("Редкий гость: Популярность увеличена на 5.");
-            }},
-            {"День защиты животных", [this]() {
-                popularity += 15;
-                cout << "День защиты животных: Популярность увеличена на 15.\n";
-                addEvent("День защиты животных: Популярность увеличена на 15.");
-            }},
-            {"Благотворительный фонд", [this]() {
-                money += 1000;
-                cout << "Благотворительный фонд: Получено 1000 монет.\n";
-                addEvent("Благотворительный фонд: Получено 1000 монет.");
-            }}
-        };
+private:
+    shared_ptr<vector<T>> column = make_shared<vector<T>>(); ///< Данные, общие для копий
+};
 
-        // Отрицательные события
-        vector<pair<string, function<void()>>> negativeEvents = {
-        {"Побег животного", [this]() {
-            popularity -= 10;
-            cout << "Побег животного: Популярность уменьшена на 10.\n";
-            addEvent("Побег животного: Популярность уменьшена на 10.");
-        }},
-        {"Протечка в системе водоснабжения", [this]() {
-            money -= 300;
-            cout << "Протечка в системе водоснабжения: Потеряно 300 монет.\n";
-            addEvent("Протечка в системе водоснабжения: Потеряно 300 монет.");
-        }},
-        {"Конфликт сотрудников", [this]() {
-            popularity -= 5;
-            cout << "Конфликт сотрудников: Популярность уменьшена на 5.\n";
-            addEvent("Конфликт сотрудников: Популярность уменьшена на 5.");
-        }},
-        {"Пожар в зоопарке", [this]() {
-            popularity -= 15;
-            money -= 500;
-            cout << "Пожар в зоопарке: Популярность уменьшена на 15, потеряно 500 монет.\n";
-            addEvent("Пожар в зоопарке: Популярность уменьшена на 15, потеряно 500 монет.");
-        }},
-        {"Штраф от экологов", [this]() {
-            money -= 200;
-            cout << "Штраф от экологов: Потеряно 200 монет.\n";
-            addEvent("Штраф от экологов: Потеряно 200 монет.");
-        }}
-        };
+/**
+ * @brief Реестр животных зоопарка (generational slot map).
+ * @details Выдаёт дескрипторы AnimalId и хранит для каждого живого животного
+ * его вольер и строку в колоночном хранилище. Поиск и удаление работают за O(1);
+ * после удаления поколение слота увеличивается, поэтому старые дескрипторы
+ * больше не находят животное, даже если слот занят заново.
+ */
+class AnimalRegistry {
+public:
+    static const uint32_t INDEX_BITS = 24;
+    static const uint32_t INDEX_MASK = (1u << INDEX_BITS) - 1;
+    static const uint32_t CHUNK_BITS = 14;                ///< Слоты хранятся частями по 2^14
+    static const uint32_t CHUNK_SIZE = 1u << CHUNK_BITS;  ///< Слотов в части; развилки копируют реестр частями
+    static const uint8_t MAX_GENERATION = 255;            ///< Последнее поколение слота; поколение 0 не выдаётся
 
+    /**
+     * @brief Положение животного в зоопарке.
+     */
+    struct Slot {
+        uint32_t row;        ///< Строка в хранилище вольера
+        int32_t enclosure;   ///< Индекс вольера или -1, если слот свободен
+        uint8_t generation;  ///< Поколение слота
+    };
 
-        // Генерация случайных событий
-        if (rand() % 100 < EVENT_PROBABILITY) {
-            bool isPositive = rand() % 2 == 0; // 50% шанс на положительное или отрицательное событие
-            auto& events = isPositive ? positiveEvents : negativeEvents;
-            if (!events.empty()) {
-                int eventIndex = rand() % events.size();
-                auto& [description, effect] = events[eventIndex];
-                cout << "Событие: " << description << "\n";
-                effect(); // Выполняем эффект события
+    /**
+     * @brief Регистрирует новое животное.
+     * @param enclosure Индекс вольера
+     * @param row Строка в хранилище вольера
+     * @return Новый дескриптор.
+     * @throws runtime_error Если закончились слоты.
+     */
+    AnimalId create(int enclosure, uint32_t row) {
+        uint32_t index;
+        if (!freeSlots.empty()) {
+            vector<uint32_t>& free = freeSlots.edit();
+            index = free.back();
+            free.pop_back();
+        }
+        else {
+            if (slotCount > INDEX_MASK) {
+                throw runtime_error("Превышено максимальное количество животных.");
             }
+            index = static_cast<uint32_t>(slotCount);
+            appendSlot({ 0, -1, 1 });
         }
+        Slot& slot = editSlot(index);
+        slot.row = row;
+        slot.enclosure = enclosure;
+        return (static_cast<uint32_t>(slot.generation) << INDEX_BITS) | index;
     }
     /**
-     * @brief Лечит животное.
-     * @param name Имя животного для лечения
+     * @brief Регистрирует блок животных, лежащих в строках [firstRow, firstRow + n) вольера.
+     * @details Слоты берутся только из конца таблицы, свободные не переиспользуются,
+     * поэтому дескрипторы блока идут подряд.
+     * @param enclosure Индекс вольера
+     * @param firstRow Строка первого животного блока
+     * @param n Количество животных
+     * @return Дескриптор первого животного; у k-го животного блока дескриптор first + k.
+     * @throws runtime_error Если закончились слоты.
      */
-    void cureAnimal(const string& name) {
-        for (auto& enc : enclosures) { // Перебираем все вольеры
-            for (auto& animal : enc.animals) { // Перебираем всех животных в вольере
-                if (animal.name == name) { // Находим животное по имени
-                    if (!animal.isInfected) { // Проверяем, заражено ли оно
-                        cout << "Животное \"" << animal.name << "\" не заражено.\n";
-                        return;
-                    }
-
-                    // Стоимость лечения
-                    const int CURE_COST = 30;
-
-                    // Запрос подтверждения на лечение
-                    cout << "Лечение животного \"" << animal.name << "\" стоит " << CURE_COST << " монет.\n";
-                    cout << "Хотите продолжить?\n";
-                    cout << "1. Да\n2. Нет\n";
-                    int confirm = getIntegerInput("Ваш выбор: ");
-                    if (confirm != 1) { // Если пользователь отказался
-                        cout << "Лечение отменено.\n";
-                        return;
-                    }
-
-                    // Проверка наличия средств
-                    if (money < CURE_COST) {
-                        cout << "Недостаточно средств для лечения!\n";
-                        return;
-                    }
-
-                    // Лечение животного
-                    animal.isInfected = false; // Лечим животное
-                    money -= CURE_COST; // Вычитаем стоимость лечения из бюджета
-                    cout << "Животное \"" << animal.name << "\" успешно вылечено!\n";
-                    return;
-                }
+    AnimalId createBlock(int enclosure, uint32_t firstRow, uint32_t n) {
+        size_t first = slotCount;
+        if (first + n > static_cast<size_t>(INDEX_MASK) + 1) {
+            throw runtime_error("Превышено максимальное количество животных.");
+        }
+        for (uint32_t k = 0; k < n;) {
+            if (slotCount % CHUNK_SIZE == 0) chunks.emplace_back();
+            vector<Slot>& chunk = chunks.back().edit();
+            uint32_t take = min(n - k, CHUNK_SIZE - static_cast<uint32_t>(slotCount % CHUNK_SIZE));
+            for (uint32_t end = k + take; k < end; ++k) {
+                chunk.push_back({ firstRow + k, enclosure, 1 });
             }
+            slotCount += take;
         }
-
-        // Если животное не найдено
-        cout << "Животное с именем \"" << name << "\" не найдено.\n";
+        return (1u << INDEX_BITS) | static_cast<uint32_t>(first);
     }
-
     /**
-     * @brief Подсчитывает общее количество животных в зоопарке.
-     * @return Общее количество животных.
+     * @brief Ищет живое животное по дескриптору.
+     * @param id Дескриптор животного
+     * @return Слот животного или nullptr, если дескриптор устарел.
      */
-    int getTotalAnimals() {
-        int total = 0;
-        for (auto& enc : enclosures) total += enc.animals.size();
-        return total;
+    const Slot* find(AnimalId id) const {
+        uint32_t index = id & INDEX_MASK;
+        if (id == NO_ANIMAL || index >= slotCount) return nullptr;
+        const Slot& slot = chunks[index >> CHUNK_BITS][index & (CHUNK_SIZE - 1)];
+        if (slot.enclosure < 0 || slot.generation != (id >> INDEX_BITS)) return nullptr;
+        return &slot;
     }
-};
-/**
- * @brief Получает целочисленный ввод от пользователя.
- * @param prompt Сообщение пользователю перед запросом ввода.
- * @return Введенное пользователем число.
- */
-int getIntegerInput(const string& prompt) {
-    int value;
-    while (true) {
-        cout << prompt;
-        cin >> value;
-        if (cin.fail()) {
-            cin.clear();
-            cin.ignore(numeric_limits<streamsize>::max(), '\n');
-            cout << "Некорректный ввод. Попробуйте снова.\n";
+    /**
+     * @brief Проверяет, живо ли животное с данным дескриптором.
+     */
+    bool contains(AnimalId id) const {
+        return find(id) != nullptr;
+    }
+    /**
+     * @brief Обновляет строку животного после перемещения внутри хранилища.
+     * @param id Дескриптор животного
+     * @param row Новая строка
+     */
+    void relocate(AnimalId id, uint32_t row) {
+        editSlot(id & INDEX_MASK).row = row;
+    }
+    /**
+     * @brief Освобождает слот; дескриптор становится недействительным.
+     * @details Слот с последним поколением больше не выдаётся: после переполнения поколения
+     * новый дескриптор совпал бы с одним из старых.
+     * @param id Дескриптор животного
+     */
+    void release(AnimalId id) {
+        uint32_t index = id & INDEX_MASK;
+        Slot& slot = editSlot(index);
+        slot.enclosure = -1;
+        if (slot.generation == MAX_GENERATION) {
+            retiredSlots++;
+            return;
         }
-        else {
-            cin.ignore(numeric_limits<streamsize>::max(), '\n');
-            return value;
+        slot.generation++;
+        freeSlots.edit().push_back(index);
+    }
+    /**
+     * @brief Количество зарегистрированных живых животных.
+     */
+    size_t size() const {
+        return slotCount - freeSlots.size() - retiredSlots;
+    }
+    /**
+     * @brief Записывает реестр в снимок.
+     */
+    void save(SnapshotWriter& out) const {
+        out.chunkedArray(chunks);
+        out.array(freeSlots.values());
+        out.pod(static_cast<uint64_t>(retiredSlots));
+    }
+    /**
+     * @brief Читает реестр из снимка.
+     */
+    void load(SnapshotReader& in) {
+        slotCount = in.chunkedArray(chunks, CHUNK_SIZE);
+        in.array(freeSlots.edit());
+        retiredSlots = static_cast<size_t>(in.pod<uint64_t>());
+    }
+    /**
+     * @brief Делает собственными все части, общие с другими копиями реестра.
+     */
+    void unshare() {
+        for (auto& chunk : chunks) chunk.edit();
+        freeSlots.edit();
+    }
+    /**
+     * @brief Байты слотов, общие с другими копиями реестра.
+     */
+    size_t sharedBytes() const {
+        size_t bytes = freeSlots.shared() ? freeSlots.size() * sizeof(uint32_t) : 0;
+        for (const auto& chunk : chunks) {
+            if (chunk.shared()) bytes += chunk.size() * sizeof(Slot);
         }
+        return bytes;
+    }
+    /**
+     * @brief Оценивает память, занятую реестром, в байтах.
+     */
+    size_t memoryUsage() const {
+        size_t bytes = chunks.capacity() * sizeof(SharedColumn<Slot>) + freeSlots.capacity() * sizeof(uint32_t);
+        for (const auto& chunk : chunks) bytes += chunk.capacity() * sizeof(Slot);
+        return bytes;
     }
-}
 
+private:
+    vector<SharedColumn<Slot>> chunks; ///< Слоты по индексу, частями по CHUNK_SIZE
+    size_t slotCount = 0;              ///< Всего слотов, включая свободные
+    SharedColumn<uint32_t> freeSlots;  ///< Индексы свободных слотов
+    size_t retiredSlots = 0;           ///< Слотов, выбывших после последнего поколения
+
+    Slot& editSlot(uint32_t index) {
+        return chunks[index >> CHUNK_BITS].edit()[index & (CHUNK_SIZE - 1)];
+    }
+    void appendSlot(const Slot& slot) {
+        if (slotCount % CHUNK_SIZE == 0) chunks.emplace_back();
+        chunks.back().edit().push_back(slot);
+        slotCount++;
+    }
+};
 /**
- * @brief Управляет сотрудниками зоопарка.
- * @param zoo Ссылка на объект зоопарка
+ * @brief Класс для представления животного.
  */
-void manageEmployees(Zoo& zoo) {
-    cout << "\n--- Управление работниками ---\n";
-    cout << "1. Нанять сотрудника\n";
-    cout << "2. Уволить сотрудника\n";
-    cout << "3. Просмотреть список\n";
-    cout << "0. Назад\n";
+class Animal {
+public:
+    enum Type { LAND, AQUATIC }; // Типы животных: Земноводные и Водоплавающие
+    enum Climate { DESERT, FOREST, ARCTIC, OCEAN }; // Климаты
+    /**
+     * @brief Раскладка байта bits; та же раскладка используется в столбце флагов AnimalStore.
+     */
+    enum Bit : uint8_t {
+        CLIMATE_MASK = 0x03,    ///< Биты 0-1: климат
+        CARNIVORE_BIT = 1 << 2, ///< Хищник
+        INFECTED_BIT = 1 << 3,  ///< Заражено
+        AQUATIC_BIT = 1 << 4,   ///< Водоплавающее
+        MALE_BIT = 1 << 5       ///< Пол 'M'
+    };
+
+    // Поля упорядочены по убыванию размера, чтобы запись не содержала дыр выравнивания
+    string name;                      ///< Имя животного
+    pair<AnimalId, AnimalId> parents; ///< Дескрипторы родителей
+    AnimalId id;                      ///< Дескриптор (NO_ANIMAL, пока животное не в зоопарке)
+    SpeciesId species;                ///< Вид животного
+    uint16_t ageInDays;               ///< Возраст в днях на момент создания копии (в зоопарке хранится день рождения)
+    uint16_t weight;                  ///< Вес
+    uint8_t bits;                     ///< Климат, тип питания, заражение, тип и пол (см. Bit)
 
-    int choice = getIntegerInput("Выберите действие: ");
-    switch (choice) {
-    case 1: {
-        cout << "\nНаем сотрудника:\n";
-        string name;
-        cout << "Введите имя: ";
-        getline(cin, name);
+    /**
+     * @brief Конструктор для создания нового животного.
+     * @param n Имя животного
+     * @param s Вид животного
+     * @param a Возраст в днях
+     * @param w Вес
+     * @param c Климат
+     * @param carn Является ли хищником
+     * @param g Пол ('M' или 'F')
+     * @param t Тип животного ('Land' или 'Aquatic')
+     * @param parent1 Дескриптор первого родителя (по умолчанию нет)
+     * @param parent2 Дескриптор второго родителя (по умолчанию нет)
+     */
 
-        cout << "1. Уборщик\n2. Ветеринар\n3. Кормилец\n";
-        int posChoice = getIntegerInput("Выберите должность: ");
-        string position;
-        int salary, maxAnimals;
-
-        switch (posChoice) {
-        case 1:
-            position = "Уборщик";
-            salary = 80;
-            maxAnimals = 20;
-            break;
-        case 2:
-            position = "Ветеринар";
-            salary = 150;
-            maxAnimals = 10;
-            break;
-        case 3:
-            position = "Кормилец";
-            salary = 100;
-            maxAnimals = 30;
-            break;
-        default:
-            cout << "Неверный выбор!\n";
-            return;
-        }
+     // Конструктор
+    Animal(string n, SpeciesId s, int a, int w, Climate c, bool carn, char g, Type t, AnimalId parent1 = NO_ANIMAL, AnimalId parent2 = NO_ANIMAL)
+        : name(n), parents({ parent1, parent2 }), id(NO_ANIMAL), species(s),
+        ageInDays(static_cast<uint16_t>(a)), weight(static_cast<uint16_t>(w)), bits(static_cast<uint8_t>(c)) {
+        // Возраст и вес хранятся в 16 битах; входные данные проверяются при чтении
+        assert(a >= 0 && a <= UINT16_MAX && w >= 0 && w <= UINT16_MAX);
+        if (carn) bits |= CARNIVORE_BIT;
+        if (t == AQUATIC) bits |= AQUATIC_BIT;
+        if (g == 'M') bits |= MALE_BIT;
+    }
 
-        if (zoo.money >= salary) {
-            zoo.employees.emplace_back(name, position, salary, maxAnimals);
-            zoo.money -= salary;
-            cout << "Сотрудник нанят!\n";
-        }
-        else {
-            cout << "Недостаточно средств!\n";
-        }
-        break;
+    Climate climate() const { return static_cast<Climate>(bits & CLIMATE_MASK); }
+    bool isCarnivore() const { return bits & CARNIVORE_BIT; }
+    bool isInfected() const { return bits & INFECTED_BIT; }
+    char gender() const { return bits & MALE_BIT ? 'M' : 'F'; }
+    Type type() const { return isAquatic() ? AQUATIC : LAND; }
+
+    void setInfected(bool infected) {
+        if (infected) bits |= INFECTED_BIT;
+        else bits &= ~INFECTED_BIT;
     }
-    case 2: {
-        cout << "\nУвольнение сотрудника:\n";
-        int index = 1;
-        for (auto& emp : zoo.employees) {
-            if (emp.position != "Директор") { // Исключаем директора
+
+    /**
+     * @brief Название вида животного.
+     */
+    const string& speciesName() const {
+        return SpeciesTable::instance().name(species);
+    }
+
+    // Метод для проверки, является ли животное водоплавающим
+    bool isAquatic() const {
+        return bits & AQUATIC_BIT;
+    }
+    /**
+     * @brief Рассчитывает цену животного если оно водоплавающее.
+     * @return Вес животного.
+     */
+    int calculateMaintenanceCost() const {
+        if (isAquatic()) {
+            return weight * 2; // Удвоенная стоимость содержания для водоплавающих
+        }
+        return weight;
+    }
+    /**
+     * @brief Рассчитывает цену животного на основе его характеристик.
+     * @return Цена животного в монетах.
+     */
+    int calculatePrice() const {
+        int basePrice = 60;
+        int price = basePrice + weight * 2 - ageInDays / 30 * 5;
+        price += isCarnivore() ? 100 : 0;
+        price += static_cast<int>(climate()) * 50;
+
+        if (isAquatic()) {
+            price += 200; // Например, дополнительная стоимость для водоплавающих
+        }
+
+        return max(price, 10);
+    }
+    /**
+     * @brief Цена, за которую зоопарк продаёт животное: 80% от цены.
+     */
+    int calculateSalePrice() const {
+        return calculatePrice() * 0.8;
+    }
+    /**
+     * @brief Вывод родителей животного.
+     * @param zoo Зоопарк, в котором ищутся родители
+     */
+    void printParents(const Zoo& zoo) const;
+    /**
+     * @brief Проверяет, умрет ли животное от старости.
+     * @param rng Генератор случайных чисел
+     * @return true, если животное умирает от старости, иначе false.
+     */
+    bool diesOfOldAge(Rng& rng) const {
+        return diesOfOldAge(ageInDays, rng);
+    }
+    /**
+     * @brief Проверяет, умрет ли животное указанного возраста от старости.
+     * @param age Возраст в днях
+     * @param rng Генератор случайных чисел
+     * @return true, если животное умирает от старости, иначе false.
+     */
+    static bool diesOfOldAge(int age, Rng& rng) {
+        if (age > 60) { // Пример: максимальный возраст = 60 дней
+            int deathChance = age - 60; // Шанс смерти = возраст - 60
+            return rng.chance(deathChance);
+        }
+        return false;
+    }
+    /**
+     * @brief Разыгрывает возраст смерти от старости одним случайным числом.
+     * @details Распределение то же, что у ежедневных бросков diesOfOldAge: на день с возрастом
+     * a > 60 животное умирает с вероятностью (a - 60)%, к 160 дням — наверняка.
+     * Возраст находится обращением функции выживания при условии, что животное дожило до age.
+     * @param age Текущий возраст в днях
+     * @param rng Генератор случайных чисел
+     * @return Возраст (больше age), на котором животное умрёт.
+     */
+    static int sampleDeathAge(int age, Rng& rng) {
+        const int OLD_AGE = 60, LAST_AGE = 160;
+        // survival[k] — вероятность дожить до возраста OLD_AGE + k, дожив до OLD_AGE
+        static const vector<double> survival = []() {
+            vector<double> s(LAST_AGE - OLD_AGE + 1, 1.0);
+            for (int k = 1; k <= LAST_AGE - OLD_AGE; ++k) {
+                s[k] = s[k - 1] * (1.0 - k / 100.0);
+            }
+            return s;
+        }();
+        int from = max(age, OLD_AGE);
+        double u = rng.uniform();
+        if (from >= LAST_AGE) return from + 1;
+        double threshold = u * survival[from - OLD_AGE];
+        // Первый возраст после from, до которого животное доживает с вероятностью не больше threshold
+        auto it = upper_bound(survival.begin() + (from - OLD_AGE + 1), survival.end(), threshold,
+            [](double value, double s) { return s <= value; });
+        return OLD_AGE + static_cast<int>(it - survival.begin());
+    }
+
+    /**
+     * @brief Перегрузка оператора + для размножения животных.
+     * @details Генератор выводится из дескрипторов и видов родителей,
+     * поэтому результат воспроизводим и не зависит от глобального состояния.
+     * @param other Второе животное для размножения.
+     * @return Новое животное, полученное в результате размножения.
+     * @throws runtime_error Если размножение невозможно.
+     */
+    Animal operator+(const Animal& other) const {
+        Rng rng(Rng::mix((static_cast<uint64_t>(id) << 32 | other.id) ^ (static_cast<uint64_t>(species) << 16 | other.species)));
+        return breed(other, rng);
+    }
+    /**
+     * @brief Размножение с явным генератором случайных чисел.
+     * @param other Второе животное для размножения.
+     * @param rng Генератор случайных чисел
+     * @return Новое животное, полученное в результате размножения.
+     * @throws runtime_error Если размножение невозможно.
+     */
+    Animal breed(const Animal& other, Rng& rng) const {
+        if (this->gender() == other.gender()) {
+            throw runtime_error("Одинаковый пол! Размножение невозможно.");
+        }
+        if (this->species == other.species) {
+            throw runtime_error("Животные одного вида не могут размножаться.");
+        }
+
+        // Генерация нового вида
+        SpeciesId newSpecies = combineSpecies(this->species, other.species, rng);
+
+        // Генерация случайного пола
+        char newGender = rng.below(2) == 0 ? 'M' : 'F';
+
+        // Определяем тип потомка
+        Type newType = this->isAquatic() || other.isAquatic() ? AQUATIC : LAND;
+
+        // Создаем новое животное
+        return Animal(
+            "",                          // Имя (пустое, так как пользователь задаст его позже)
+            newSpecies,                  // Новый вид
+            1,                           // Возраст (1 день)
+            (this->weight + other.weight) / 2, // Средний вес
+            this->climate(),             // Климат
+            this->isCarnivore() || other.isCarnivore(), // Тип питания
+            newGender,                  // Пол
+            newType                      // Тип животного
+        );
+    }
+};
+/**
+ * @brief Счётчики животных по признакам.
+ * @details Ведутся хранилищем при каждом добавлении, удалении, заражении и лечении,
+ * поэтому чтение не требует обхода животных.
+ */
+struct AnimalCounts {
+    int animals = 0;     ///< Всего животных
+    int infected = 0;    ///< Заражённых
+    int aquatic = 0;     ///< Водоплавающих
+    int carnivores = 0;  ///< Хищников
+
+    /**
+     * @brief Учитывает животное с флагами bits.
+     * @param bits Флаги животного (раскладка Animal::bits)
+     * @param sign +1 при добавлении, -1 при удалении
+     */
+    void apply(uint8_t bits, int sign) {
+        animals += sign;
+        if (bits & Animal::INFECTED_BIT) infected += sign;
+        if (bits & Animal::AQUATIC_BIT) aquatic += sign;
+        if (bits & Animal::CARNIVORE_BIT) carnivores += sign;
+    }
+    AnimalCounts& operator+=(const AnimalCounts& other) {
+        animals += other.animals;
+        infected += other.infected;
+        aquatic += other.aquatic;
+        carnivores += other.carnivores;
+        return *this;
+    }
+    bool operator==(const AnimalCounts& other) const {
+        return animals == other.animals && infected == other.infected
+            && aquatic == other.aquatic && carnivores == other.carnivores;
+    }
+};
+
+/**
+ * @brief Колоночное хранилище животных вольера.
+ * @details Каждое поле животного лежит в отдельном непрерывном массиве (structure of arrays).
+ * Ежедневные проходы (старение, заражение, подсчёт больных) читают только плотные
+ * "горячие" столбцы: возраст, вес и байт флагов. Виды, дескрипторы, имена и родители
+ * вынесены в "холодные" столбцы и нужны только при выводе на экран.
+ * Имена хранятся в пуле хранилища, в столбце лежит только 32-битный дескриптор имени;
+ * у животных без имени дескриптор равен 0 и строка не выделяется.
+ */
+class AnimalStore {
+public:
+    /**
+     * @brief Битовые флаги животного; совпадают с раскладкой Animal::bits.
+     */
+    enum Flag : uint8_t {
+        CLIMATE = Animal::CLIMATE_MASK,  ///< Биты климата
+        CARNIVORE = Animal::CARNIVORE_BIT, ///< Хищник
+        INFECTED = Animal::INFECTED_BIT,   ///< Заражено
+        AQUATIC = Animal::AQUATIC_BIT,     ///< Водоплавающее
+        MALE = Animal::MALE_BIT,           ///< Пол 'M'
+        DEAD = 1 << 6                      ///< Помечено на удаление (см. removeDead)
+    };
+
+    // Столбцы разделяются с копиями хранилища и копируются при первом изменении (см. SharedColumn)
+
+    // Горячие столбцы
+    SharedColumn<uint16_t> weights;  ///< Вес
+    SharedColumn<uint8_t> flags;     ///< Климат и флаги (см. Flag)
+
+    // Холодные столбцы
+    SharedColumn<SpeciesId> species; ///< Вид
+    SharedColumn<uint16_t> birthDays; ///< День рождения по счёту Zoo::day, по модулю 2^16 (см. age)
+    SharedColumn<AnimalId> ids;      ///< Дескрипторы животных
+    SharedColumn<uint32_t> nameHandles; ///< Дескрипторы имён в пуле (0 — без имени)
+    SharedColumn<pair<AnimalId, AnimalId>> parents; ///< Дескрипторы родителей
+    SharedColumn<uint32_t> deathDays;   ///< День смерти от старости из календаря (см. DeathCalendar)
+
+    size_t size() const { return flags.size(); }
+    bool empty() const { return flags.empty(); }
+
+    Animal::Climate climate(size_t i) const { return static_cast<Animal::Climate>(flags[i] & CLIMATE); }
+    bool isCarnivore(size_t i) const { return flags[i] & CARNIVORE; }
+    bool isInfected(size_t i) const { return flags[i] & INFECTED; }
+    bool isAquatic(size_t i) const { return flags[i] & AQUATIC; }
+    char gender(size_t i) const { return flags[i] & MALE ? 'M' : 'F'; }
+    const string& speciesName(size_t i) const { return SpeciesTable::instance().name(species[i]); }
+    const string& name(size_t i) const { return namePool[nameHandles[i]]; }
+    /**
+     * @brief Возраст животного, выведенный из дня рождения.
+     * @details Вычитание по модулю 2^16 верно, пока возраст меньше 65536 дней.
+     * @param i Индекс животного
+     * @param today Текущий день зоопарка
+     */
+    int age(size_t i, int today) const { return static_cast<uint16_t>(today - birthDays[i]); }
+
+    /**
+     * @brief Счётчики животных хранилища.
+     */
+    const AnimalCounts& counts() const { return ownCounts; }
+    /**
+     * @brief Подключает счётчики владельца, которые будут меняться вместе со счётчиками хранилища.
+     * @details Уже учтённые животные к ним не прибавляются.
+     * @param parent Счётчики зоопарка или nullptr
+     */
+    void attachCounts(AnimalCounts* parent) { parentCounts = parent; }
+    /**
+     * @brief Пересчитывает счётчики обходом всех животных (для проверки).
+     */
+    AnimalCounts recount() const {
+        AnimalCounts result;
+        for (uint8_t f : flags) result.apply(f, +1);
+        return result;
+    }
+
+    void setInfected(size_t i, bool infected) {
+        if (isInfected(i) == infected) return;
+        if (infected) ZOO_COUNT(COUNTER_INFECTIONS, 1);
+        int sign = infected ? +1 : -1;
+        ownCounts.infected += sign;
+        if (parentCounts) parentCounts->infected += sign;
+        if (infected) flags.edit()[i] |= INFECTED;
+        else flags.edit()[i] &= ~INFECTED;
+    }
+    /**
+     * @brief Меняет имя животного.
+     * @param i Индекс животного
+     * @param name Новое имя
+     */
+    void setName(size_t i, const string& name) {
+        if (nameHandles[i] != 0 && !name.empty()) {
+            namePool.edit()[nameHandles[i]] = name;
+            return;
+        }
+        releaseName(nameHandles[i]);
+        nameHandles.edit()[i] = allocateName(name);
+    }
+    /**
+     * @brief Помечает животное на удаление; строка остаётся на месте до вызова removeDead().
+     * @param i Индекс животного
+     */
+    void markDead(size_t i) { flags.edit()[i] |= DEAD; }
+    /**
+     * @brief Записывает заранее разыгранный день смерти животного.
+     * @param i Индекс животного
+     * @param day День смерти
+     */
+    void setDeathDay(size_t i, uint32_t day) { deathDays.edit()[i] = day; }
+
+    /**
+     * @brief Резервирует место под n животных во всех столбцах.
+     * @param n Количество животных
+     */
+    void reserve(size_t n) {
+        edit().reserve(n);
+    }
+    /**
+     * @brief Добавляет животное в конец хранилища.
+     * @param animal Животное для добавления
+     * @param id Дескриптор, выданный реестром
+     * @param today Текущий день зоопарка; по нему и возрасту животного вычисляется день рождения
+     */
+    void push(const Animal& animal, AnimalId id, int today) {
+        uint32_t nameHandle = allocateName(animal.name);
+        Rows rows = edit();
+        rows.weights.push_back(animal.weight);
+        rows.flags.push_back(animal.bits);
+        track(animal.bits, +1);
+        rows.species.push_back(animal.species);
+        rows.birthDays.push_back(static_cast<uint16_t>(today - animal.ageInDays));
+        rows.ids.push_back(id);
+        rows.nameHandles.push_back(nameHandle);
+        rows.parents.push_back(animal.parents);
+        rows.deathDays.push_back(0);
+    }
+    /**
+     * @brief Добавляет блок безымянных животных без родителей.
+     * @details Столбцы увеличиваются один раз, а не на каждое животное, как в push().
+     * @param n Количество животных
+     * @param firstId Дескриптор первого животного; дескрипторы идут подряд (AnimalRegistry::createBlock)
+     * @param today Текущий день зоопарка
+     * @param make make(k) возвращает k-е животное блока; его имя и родители не сохраняются
+     */
+    template <typename Make>
+    void appendBlock(size_t n, AnimalId firstId, int today, Make make) {
+        size_t first = size();
+        Rows rows = edit();
+        rows.resize(first + n);
+        for (size_t k = 0; k < n; ++k) {
+            Animal animal = make(k);
+            size_t i = first + k;
+            rows.weights[i] = animal.weight;
+            rows.flags[i] = animal.bits;
+            track(animal.bits, +1);
+            rows.species[i] = animal.species;
+            rows.birthDays[i] = static_cast<uint16_t>(today - animal.ageInDays);
+            rows.ids[i] = firstId + static_cast<AnimalId>(k);
+            rows.parents[i] = { NO_ANIMAL, NO_ANIMAL };
+        }
+    }
+    /**
+     * @brief Собирает животное из столбцов.
+     * @param i Индекс животного
+     * @param today Текущий день зоопарка, на который вычисляется возраст
+     * @return Копия животного.
+     */
+    Animal get(size_t i, int today) const {
+        Animal animal(name(i), species[i], age(i, today), weights[i], climate(i),
+            isCarnivore(i), gender(i), isAquatic(i) ? Animal::AQUATIC : Animal::LAND,
+            parents[i].first, parents[i].second);
+        animal.id = ids[i];
+        animal.setInfected(isInfected(i));
+        return animal;
+    }
+    /**
+     * @brief Удаляет одно животное за O(1).
+     * @details На место удалённого переносится последнее животное, его строка обновляется в реестре.
+     * @param i Индекс животного
+     * @param registry Реестр животных зоопарка
+     */
+    void erase(size_t i, AnimalRegistry& registry) {
+        track(flags[i], -1);
+        registry.release(ids[i]);
+        releaseName(nameHandles[i]);
+        size_t last = size() - 1;
+        Rows rows = edit();
+        if (i != last) {
+            rows.move(i, last);
+            registry.relocate(ids[i], static_cast<uint32_t>(i));
+        }
+        rows.resize(last);
+    }
+    /**
+     * @brief Удаляет всех животных, помеченных markDead(), за один проход.
+     * @details Порядок оставшихся животных сохраняется.
+     * @param registry Реестр животных зоопарка
+     * @return Количество удалённых животных.
+     */
+    size_t removeDead(AnimalRegistry& registry) {
+        return removeIf(registry, [this](size_t i) { return (flags[i] & DEAD) != 0; });
+    }
+    /**
+     * @brief Удаляет животных, для которых условие истинно, за один проход.
+     * @details Условие вызывается ровно один раз для каждой строки по порядку, пока строка
+     * ещё на своём месте, и может менять её столбцы. Порядок оставшихся животных сохраняется.
+     * Пока никто не умер, столбцы не копируются, даже если их разделяет развилка.
+     * @param registry Реестр животных зоопарка
+     * @param dies Условие удаления: dies(i) для строки i
+     * @return Количество удалённых животных.
+     */
+    template <typename Predicate>
+    size_t removeIf(AnimalRegistry& registry, Predicate dies) {
+        ZOO_COUNT(COUNTER_SCANNED, size());
+        size_t first = 0;
+        while (first < size() && !dies(first)) first++; // До первой смерти строки остаются на местах
+        if (first == size()) return 0;
+        Rows rows = edit();
+        size_t out = first;
+        for (size_t i = first; i < size(); ++i) {
+            if (i == first || dies(i)) { // Строка first уже проверена
+                track(flags[i], -1);
+                registry.release(ids[i]);
+                releaseName(nameHandles[i]);
+                continue;
+            }
+            rows.move(out, i);
+            registry.relocate(ids[out], static_cast<uint32_t>(out));
+            out++;
+        }
+        size_t removed = size() - out;
+        rows.resize(out);
+        return removed;
+    }
+    /**
+     * @brief Записывает хранилище в снимок: столбцы целиком, пул имён и счётчики.
+     */
+    void save(SnapshotWriter& out) const {
+        out.array(weights.values()); out.array(flags.values()); out.array(species.values()); out.array(birthDays.values());
+        out.array(ids.values()); out.array(nameHandles.values()); out.array(parents.values()); out.array(deathDays.values());
+        out.pod(static_cast<uint64_t>(namePool.size()));
+        for (const string& name : namePool) out.str(name);
+        out.array(freeNames.values());
+        out.pod(ownCounts);
+    }
+    /**
+     * @brief Читает хранилище из снимка; счётчики владельца нужно пересобрать отдельно.
+     * @throws runtime_error Если снимок повреждён.
+     */
+    void load(SnapshotReader& in) {
+        Rows rows = edit();
+        in.array(rows.weights); in.array(rows.flags); in.array(rows.species); in.array(rows.birthDays);
+        in.array(rows.ids); in.array(rows.nameHandles); in.array(rows.parents); in.array(rows.deathDays);
+        vector<string>& names = namePool.edit();
+        names.resize(static_cast<size_t>(in.pod<uint64_t>()));
+        for (string& name : names) name = in.str();
+        in.array(freeNames.edit());
+        in.pod(ownCounts);
+        size_t n = flags.size();
+        bool consistent = weights.size() == n && species.size() == n && birthDays.size() == n && ids.size() == n
+            && nameHandles.size() == n && parents.size() == n && deathDays.size() == n && !namePool.empty();
+        for (size_t i = 0; consistent && i < n; ++i) consistent = nameHandles[i] < namePool.size();
+        if (!consistent) throw runtime_error("Снимок повреждён: столбцы хранилища не согласованы");
+    }
+    /**
+     * @brief Делает собственными все столбцы, общие с другими копиями хранилища.
+     */
+    void unshare() {
+        edit();
+        namePool.edit();
+        freeNames.edit();
+    }
+    /**
+     * @brief Байты столбцов, общих с другими копиями хранилища (строки имён не считаются).
+     */
+    size_t sharedBytes() const {
+        size_t bytes = 0;
+        auto add = [&bytes](const auto& column) {
+            if (column.shared()) bytes += column.size() * sizeof(column[0]);
+        };
+        add(weights); add(flags); add(species); add(birthDays);
+        add(ids); add(nameHandles); add(parents); add(deathDays);
+        add(namePool); add(freeNames);
+        return bytes;
+    }
+    /**
+     * @brief Оценивает память, занятую хранилищем.
+     * @return Количество байт: ёмкость всех столбцов и строки пула имён.
+     */
+    size_t memoryUsage() const {
+        size_t bytes = weights.capacity() * sizeof(uint16_t)
+            + flags.capacity() * sizeof(uint8_t) + species.capacity() * sizeof(SpeciesId)
+            + birthDays.capacity() * sizeof(uint16_t)
+            + ids.capacity() * sizeof(AnimalId) + nameHandles.capacity() * sizeof(uint32_t)
+            + parents.capacity() * sizeof(pair<AnimalId, AnimalId>) + deathDays.capacity() * sizeof(uint32_t)
+            + namePool.capacity() * sizeof(string) + freeNames.capacity() * sizeof(uint32_t);
+        for (const string& name : namePool) {
+            if (name.capacity() > 15) bytes += name.capacity() + 1; // Строки длиннее SSO-буфера
+        }
+        return bytes;
+    }
+
+private:
+    SharedColumn<string> namePool = nameless(); ///< Пул имён; элемент 0 — пустое имя
+    SharedColumn<uint32_t> freeNames;          ///< Свободные элементы пула
+    AnimalCounts ownCounts;          ///< Счётчики животных хранилища
+    AnimalCounts* parentCounts = nullptr; ///< Счётчики зоопарка-владельца
+
+    void track(uint8_t bits, int sign) {
+        ownCounts.apply(bits, sign);
+        if (parentCounts) parentCounts->apply(bits, sign);
+    }
+
+    /**
+     * @brief Изменяемые ссылки на все столбцы; берутся один раз перед правкой многих строк.
+     */
+    struct Rows {
+        vector<uint16_t>& weights;
+        vector<uint8_t>& flags;
+        vector<SpeciesId>& species;
+        vector<uint16_t>& birthDays;
+        vector<AnimalId>& ids;
+        vector<uint32_t>& nameHandles;
+        vector<pair<AnimalId, AnimalId>>& parents;
+        vector<uint32_t>& deathDays;
+
+        void move(size_t to, size_t from) {
+            weights[to] = weights[from];
+            flags[to] = flags[from];
+            species[to] = species[from];
+            birthDays[to] = birthDays[from];
+            ids[to] = ids[from];
+            nameHandles[to] = nameHandles[from];
+            parents[to] = parents[from];
+            deathDays[to] = deathDays[from];
+        }
+        void resize(size_t n) {
+            weights.resize(n); flags.resize(n);
+            species.resize(n); birthDays.resize(n); ids.resize(n); nameHandles.resize(n); parents.resize(n); deathDays.resize(n);
+        }
+        void reserve(size_t n) {
+            weights.reserve(n); flags.reserve(n);
+            species.reserve(n); birthDays.reserve(n); ids.reserve(n); nameHandles.reserve(n); parents.reserve(n); deathDays.reserve(n);
+        }
+    };
+    /**
+     * @brief Делает все столбцы собственными и возвращает ссылки на них.
+     */
+    Rows edit() {
+        return { weights.edit(), flags.edit(), species.edit(), birthDays.edit(),
+            ids.edit(), nameHandles.edit(), parents.edit(), deathDays.edit() };
+    }
+    static SharedColumn<string> nameless() {
+        SharedColumn<string> pool;
+        pool.edit().push_back("");
+        return pool;
+    }
+
+    uint32_t allocateName(const string& name) {
+        if (name.empty()) return 0;
+        if (!freeNames.empty()) {
+            vector<uint32_t>& free = freeNames.edit();
+            uint32_t handle = free.back();
+            free.pop_back();
+            namePool.edit()[handle] = name;
+            return handle;
+        }
+        namePool.edit().push_back(name);
+        return static_cast<uint32_t>(namePool.size()) - 1;
+    }
+    void releaseName(uint32_t handle) {
+        if (handle == 0) return;
+        namePool.edit()[handle].clear();
+        freeNames.edit().push_back(handle);
+    }
+};
+/**
+ * @brief Итоги дневного прохода по животным (вольера или всего зоопарка).
+ */
+struct DayTally {
+    int oldAgeDeaths = 0; ///< Умерло от старости
+    int virusDeaths = 0;  ///< Умерло от терановируса
+    int infected = 0;     ///< Заражено в конце прохода
+    int animals = 0;      ///< Животных в конце прохода
+
+    DayTally& operator+=(const DayTally& other) {
+        oldAgeDeaths += other.oldAgeDeaths;
+        virusDeaths += other.virusDeaths;
+        infected += other.infected;
+        animals += other.animals;
+        return *this;
+    }
+};
+
+/**
+ * @brief Календарь смертей от старости: колесо из дневных корзин с дескрипторами животных.
+ * @details День смерти разыгрывается один раз, когда животное попадает в зоопарк,
+ * поэтому за день обрабатываются только животные, которые в этот день умирают.
+ * Отсрочка не превышает 160 дней, так что корзины не переполняются по кругу.
+ * Записи проданных животных не удаляются: при срабатывании их отсеивает реестр
+ * и сверка со столбцом AnimalStore::deathDays.
+ */
+class DeathCalendar {
+public:
+    static const uint32_t WHEEL_SIZE = 256; ///< Число корзин (степень двойки больше максимальной отсрочки)
+
+    /**
+     * @brief Ставит смерть животного на день.
+     * @param id Дескриптор животного
+     * @param day День зоопарка, в nextDay которого животное умрёт
+     */
+    void schedule(AnimalId id, uint32_t day) {
+        buckets[day & (WHEEL_SIZE - 1)].edit().push_back(id);
+    }
+    /**
+     * @brief Корзина дня; после обработки её нужно очистить через clearDay().
+     * @param day День зоопарка
+     */
+    const SharedColumn<AnimalId>& due(uint32_t day) const {
+        return buckets[day & (WHEEL_SIZE - 1)];
+    }
+    /**
+     * @brief Очищает корзину дня.
+     * @param day День зоопарка
+     */
+    void clearDay(uint32_t day) {
+        buckets[day & (WHEEL_SIZE - 1)].clear();
+    }
+    /**
+     * @brief Удаляет все записи.
+     */
+    void clear() {
+        for (auto& bucket : buckets) bucket.clear();
+    }
+    /**
+     * @brief Делает собственными корзины, общие с другими копиями календаря.
+     */
+    void unshare() {
+        for (auto& bucket : buckets) bucket.edit();
+    }
+    /**
+     * @brief Байты корзин, общих с другими копиями календаря.
+     */
+    size_t sharedBytes() const {
+        size_t bytes = 0;
+        for (const auto& bucket : buckets) {
+            if (bucket.shared()) bytes += bucket.size() * sizeof(AnimalId);
+        }
+        return bytes;
+    }
+    /**
+     * @brief Записывает корзины в снимок.
+     */
+    void save(SnapshotWriter& out) const {
+        for (const auto& bucket : buckets) out.array(bucket.values());
+    }
+    /**
+     * @brief Читает корзины из снимка.
+     */
+    void load(SnapshotReader& in) {
+        for (auto& bucket : buckets) in.array(bucket.edit());
+    }
+
+private:
+    vector<SharedColumn<AnimalId>> buckets = vector<SharedColumn<AnimalId>>(WHEEL_SIZE); ///< Корзины по дням
+};
+
+/**
+ * @brief Типы записей журнала событий.
+ */
+enum class EventType : uint8_t {
+    INFECTION,    ///< Животное заразилось
+    DEATH,        ///< Животное умерло (причина в EventRecord::detail)
+    BIRTH,        ///< Родилось животное
+    PURCHASE,     ///< Куплено животное
+    SALE,         ///< Продано животное
+    RANDOM_EVENT, ///< Случайное событие (номер в RANDOM_EVENTS в EventRecord::detail)
+    PAYROLL       ///< Выплачены зарплаты
+};
+
+/**
+ * @brief Причины смерти для записей EventType::DEATH.
+ */
+enum class DeathCause : uint8_t {
+    OLD_AGE,    ///< Старость
+    VIRUS,      ///< Терановирус
+    STARVATION  ///< Голод
+};
+
+/**
+ * @brief Запись журнала событий фиксированного размера.
+ */
+struct EventRecord {
+    uint32_t day;       ///< День зоопарка
+    AnimalId animal;    ///< Животное или NO_ANIMAL
+    int32_t amount;     ///< Изменение денег в монетах (0, если событие их не касается)
+    EventType type;     ///< Тип события
+    uint8_t detail;     ///< Причина смерти или номер случайного события
+    uint16_t enclosure; ///< Номер вольера или NO_ENCLOSURE
+
+    static const uint16_t NO_ENCLOSURE = 0xFFFF;
+};
+static_assert(sizeof(EventRecord) == 16, "Запись журнала должна занимать 16 байт");
+
+/**
+ * @brief Журнал событий: кольцевой буфер записей фиксированной ёмкости.
+ * @details Буфер выделяется один раз, поэтому запись события не выделяет память.
+ * Если подключён файл (spillTo), заполненный буфер целиком дописывается в него,
+ * иначе новые записи вытесняют самые старые. Файл — заголовок FILE_MAGIC и записи
+ * EventRecord подряд в порядке байтов машины. В текст записи переводит printEvent.
+ */
+class EventLog {
+public:
+    static const size_t DEFAULT_CAPACITY = 4096;  ///< Ёмкость буфера по умолчанию
+    static constexpr char FILE_MAGIC[8] = { 'Z', 'O', 'O', 'E', 'V', 'T', '0', '1' }; ///< Заголовок файла
+
+    /**
+     * @param capacity Ёмкость буфера в записях
+     */
+    explicit EventLog(size_t capacity = DEFAULT_CAPACITY) : records(capacity) {}
+    /**
+     * @brief Копирует записи буфера; файл остаётся только у оригинала.
+     */
+    EventLog(const EventLog& other)
+        : records(other.records), head(other.head), count(other.count), total(other.total), file(nullptr) {}
+    EventLog& operator=(const EventLog&) = delete;
+    ~EventLog() {
+        close();
+    }
+
+    /**
+     * @brief Добавляет запись.
+     */
+    void record(const EventRecord& event) {
+        if (count == records.size()) {
+            if (file) {
+                spill();
+            }
+            else {
+                head = next(head);
+                count--;
+            }
+        }
+        size_t slot = head + count;
+        if (slot >= records.size()) slot -= records.size();
+        records[slot] = event;
+        count++;
+        total++;
+    }
+    /**
+     * @brief Количество записей в буфере.
+     */
+    size_t size() const { return count; }
+    /**
+     * @brief Запись буфера по порядку, начиная с самой старой.
+     */
+    const EventRecord& operator[](size_t i) const {
+        size_t slot = head + i;
+        return records[slot >= records.size() ? slot - records.size() : slot];
+    }
+    /**
+     * @brief Сколько записей сделано за всё время, включая вытесненные и сброшенные в файл.
+     */
+    uint64_t recorded() const { return total; }
+
+    /**
+     * @brief Подключает файл, в который будет сбрасываться заполненный буфер.
+     * @param path Путь к файлу; существующий файл перезаписывается
+     * @throws runtime_error Если файл не открывается.
+     */
+    void spillTo(const string& path) {
+        close();
+        file = fopen(path.c_str(), "wb");
+        if (!file || fwrite(FILE_MAGIC, sizeof(FILE_MAGIC), 1, file) != 1) {
+            close();
+            throw runtime_error("Не удалось открыть файл журнала событий: " + path);
+        }
+    }
+    /**
+     * @brief Дописывает содержимое буфера в файл и очищает буфер.
+     */
+    void flush() {
+        if (!file) return;
+        spill();
+        fflush(file);
+    }
+    /**
+     * @brief Сбрасывает буфер и закрывает файл.
+     */
+    void close() {
+        if (!file) return;
+        spill();
+        fclose(file);
+        file = nullptr;
+    }
+    /**
+     * @brief Записывает содержимое буфера в снимок; файл сброса в снимок не входит.
+     */
+    void save(SnapshotWriter& out) const {
+        vector<EventRecord> ordered;
+        ordered.reserve(count);
+        for (size_t i = 0; i < count; ++i) ordered.push_back((*this)[i]);
+        out.array(ordered);
+        out.pod(total);
+    }
+    /**
+     * @brief Заменяет содержимое буфера записями из снимка.
+     */
+    void load(SnapshotReader& in) {
+        vector<EventRecord> ordered;
+        in.array(ordered);
+        head = 0;
+        count = 0;
+        for (const EventRecord& event : ordered) record(event);
+        in.pod(total);
+    }
+    /**
+     * @brief Читает записи из файла журнала.
+     * @param path Путь к файлу
+     * @return Записи в порядке добавления.
+     * @throws runtime_error Если файл не открывается или не является журналом событий.
+     */
+    static vector<EventRecord> readFile(const string& path) {
+        ifstream in(path, ios::binary);
+        char magic[sizeof(FILE_MAGIC)];
+        if (!in || !in.read(magic, sizeof(magic)) || !equal(magic, magic + sizeof(magic), FILE_MAGIC)) {
+            throw runtime_error("Не является файлом журнала событий: " + path);
+        }
+        vector<EventRecord> events;
+        EventRecord event;
+        while (in.read(reinterpret_cast<char*>(&event), sizeof(event))) {
+            events.push_back(event);
+        }
+        return events;
+    }
+
+private:
+    vector<EventRecord> records; ///< Кольцевой буфер
+    size_t head = 0;             ///< Индекс самой старой записи
+    size_t count = 0;            ///< Записей в буфере
+    uint64_t total = 0;          ///< Записей за всё время
+    FILE* file = nullptr;        ///< Файл для сброса буфера или nullptr
+
+    size_t next(size_t slot) const {
+        return slot + 1 == records.size() ? 0 : slot + 1;
+    }
+    void spill() {
+        // Содержимое кольца — не больше двух непрерывных кусков
+        size_t first = min(count, records.size() - head);
+        fwrite(records.data() + head, sizeof(EventRecord), first, file);
+        fwrite(records.data(), sizeof(EventRecord), count - first, file);
+        head = 0;
+        count = 0;
+    }
+};
+
+/**
+ * @brief Журнал действий игрока для воспроизведения (--journal, --replay).
+ * @details Текстовый файл, одна строка на действие: заголовок ZOOJRN с версией, строка zoo
+ * с зерном генераторов, капиталом и названием, затем build, upgrade, buy, sell, cure,
+ * breed (за ней строки name с именами потомков), hire, fire, food, advertise, market,
+ * rename и day с хешем состояния после nextDay. Строковый аргумент всегда последний.
+ * Каждая строка сразу сбрасывается на диск, поэтому журнал переживает аварийное завершение.
+ * Журнал не копируется вместе с зоопарком.
+ */
+class ActionJournal {
+public:
+    static constexpr int VERSION = 1; ///< Версия формата журнала
+
+    ActionJournal() = default;
+    ~ActionJournal() {
+        close();
+    }
+    ActionJournal(const ActionJournal&) = delete;
+    ActionJournal& operator=(const ActionJournal&) = delete;
+
+    /**
+     * @brief Создаёт файл журнала и пишет заголовок.
+     * @param path Путь к файлу; существующий файл перезаписывается
+     * @throws runtime_error Если файл не создаётся.
+     */
+    void open(const string& path) {
+        close();
+        file = fopen(path.c_str(), "w");
+        if (!file) throw runtime_error("Не удалось создать журнал действий: " + path);
+        record("ZOOJRN", VERSION);
+    }
+    /**
+     * @brief Ведётся ли журнал.
+     */
+    bool isOpen() const {
+        return file != nullptr;
+    }
+    /**
+     * @brief Дописывает строку действия; без открытого файла ничего не делает.
+     * @param action Имя действия
+     * @param args Аргументы через пробел
+     */
+    template <typename... Args>
+    void record(const string& action, const Args&... args) {
+        if (!file) return;
+        ostringstream line;
+        line << action;
+        ((line << ' ' << args), ...);
+        line << '\n';
+        const string text = line.str();
+        fwrite(text.data(), 1, text.size(), file);
+        fflush(file);
+    }
+    /**
+     * @brief Закрывает файл журнала.
+     */
+    void close() {
+        if (file) fclose(file);
+        file = nullptr;
+    }
+
+private:
+    FILE* file = nullptr; ///< Файл журнала или nullptr
+};
+
+/**
+ * @brief Показатели дня, которые записывает MetricsRecorder; по столбцу на показатель.
+ */
+enum DayMetric {
+    METRIC_DAY,               ///< День зоопарка
+    METRIC_MONEY,             ///< Деньги в конце дня
+    METRIC_FOOD,              ///< Еда в конце дня
+    METRIC_POPULARITY,        ///< Популярность в конце дня
+    METRIC_VISITORS,          ///< Посетители
+    METRIC_INCOME,            ///< Доход от посетителей
+    METRIC_PAYROLL,           ///< Зарплаты
+    METRIC_ENCLOSURE_COST,    ///< Расходы на вольеры
+    METRIC_FEED_COST,         ///< Расходы на питание
+    METRIC_DEATHS_OLD_AGE,    ///< Умерло от старости
+    METRIC_DEATHS_VIRUS,      ///< Умерло от терановируса
+    METRIC_DEATHS_STARVATION, ///< Умерло от голода
+    METRIC_INFECTIONS,        ///< Новых заражений
+    METRIC_INFECTED,          ///< Заражённых в конце дня
+    METRIC_ANIMALS,           ///< Животных в конце дня
+    METRIC_COUNT
+};
+
+/**
+ * @brief Имена столбцов показателей в файле и в CSV.
+ */
+const char* const METRIC_KEYS[METRIC_COUNT] = { "day", "money", "food", "popularity", "visitors", "income",
+    "payroll", "enclosure_cost", "feed_cost", "deaths_old_age", "deaths_virus", "deaths_starvation",
+    "infections", "infected", "animals" };
+
+/**
+ * @brief Строка показателей одного дня.
+ */
+using DayMetrics = array<int32_t, METRIC_COUNT>;
+
+/**
+ * @brief Файл показателей по дням (--metrics), общий для всех прогонов серии.
+ * @details Столбцовый формат: заголовок FILE_MAGIC, число столбцов и их имена (байт длины
+ * и символы), затем блоки: номер прогона, число строк и столбцы блока подряд, по int32 на
+ * значение, в порядке байтов машины. Если путь оканчивается на .csv, вместо блоков пишутся
+ * строки CSV. Блоки пишут прогоны из разных потоков, поэтому запись защищена мьютексом,
+ * а блоки разных прогонов могут чередоваться; каждый блок помечен номером прогона.
+ */
+class MetricsFile {
+public:
+    static constexpr char FILE_MAGIC[8] = { 'Z', 'O', 'O', 'M', 'E', 'T', '0', '1' }; ///< Заголовок файла
+
+    /**
+     * @brief Создаёт файл и пишет заголовок.
+     * @param path Путь к файлу; существующий файл перезаписывается
+     * @throws runtime_error Если файл не создаётся.
+     */
+    explicit MetricsFile(const string& path)
+        : csv(path.size() >= 4 && path.compare(path.size() - 4, 4, ".csv") == 0) {
+        file = fopen(path.c_str(), csv ? "w" : "wb");
+        if (!file) throw runtime_error("Не удалось создать файл показателей: " + path);
+        if (csv) {
+            fputs("run", file);
+            for (const char* key : METRIC_KEYS) fprintf(file, ",%s", key);
+            fputc('\n', file);
+            return;
+        }
+        uint32_t columns = METRIC_COUNT;
+        fwrite(FILE_MAGIC, sizeof(FILE_MAGIC), 1, file);
+        fwrite(&columns, sizeof(columns), 1, file);
+        for (const char* key : METRIC_KEYS) {
+            uint8_t length = static_cast<uint8_t>(strlen(key));
+            fwrite(&length, sizeof(length), 1, file);
+            fwrite(key, 1, length, file);
+        }
+    }
+    ~MetricsFile() {
+        fclose(file);
+    }
+    MetricsFile(const MetricsFile&) = delete;
+    MetricsFile& operator=(const MetricsFile&) = delete;
+
+    /**
+     * @brief Дописывает блок строк одного прогона.
+     * @param run Номер прогона
+     * @param columns Столбцы подряд, каждый длиной stride
+     * @param stride Расстояние между началами столбцов
+     * @param rows Строк в блоке
+     */
+    void writeBlock(uint32_t run, const int32_t* columns, size_t stride, uint32_t rows) {
+        lock_guard<mutex> guard(lock);
+        if (csv) {
+            for (uint32_t r = 0; r < rows; ++r) {
+                fprintf(file, "%u", run);
+                for (int c = 0; c < METRIC_COUNT; ++c) fprintf(file, ",%d", columns[c * stride + r]);
+                fputc('\n', file);
+            }
+            return;
+        }
+        fwrite(&run, sizeof(run), 1, file);
+        fwrite(&rows, sizeof(rows), 1, file);
+        for (int c = 0; c < METRIC_COUNT; ++c) fwrite(columns + c * stride, sizeof(int32_t), rows, file);
+    }
+    /**
+     * @brief Пишет столбцовый файл показателей в CSV.
+     * @param path Путь к файлу, записанному MetricsFile
+     * @param out Поток для CSV
+     * @return Строк записано.
+     * @throws runtime_error Если файл не открывается, не является файлом показателей или обрезан.
+     */
+    static uint64_t printCsv(const string& path, ostream& out) {
+        ifstream in(path, ios::binary);
+        char magic[sizeof(FILE_MAGIC)];
+        uint32_t columns = 0;
+        if (!in || !in.read(magic, sizeof(magic)) || !equal(magic, magic + sizeof(magic), FILE_MAGIC)
+            || !in.read(reinterpret_cast<char*>(&columns), sizeof(columns))) {
+            throw runtime_error("Не является файлом показателей: " + path);
+        }
+        out << "run";
+        for (uint32_t c = 0; c < columns; ++c) {
+            uint8_t length = 0;
+            string key;
+            if (!in.read(reinterpret_cast<char*>(&length), sizeof(length))) throw runtime_error("Файл показателей обрезан: " + path);
+            key.resize(length);
+            if (!in.read(&key[0], length)) throw runtime_error("Файл показателей обрезан: " + path);
+            out << "," << key;
+        }
+        out << "\n";
+        uint64_t total = 0;
+        uint32_t header[2]; // Номер прогона и число строк
+        vector<int32_t> block;
+        while (in.read(reinterpret_cast<char*>(header), sizeof(header))) {
+            block.resize(static_cast<size_t>(header[1]) * columns);
+            if (!in.read(reinterpret_cast<char*>(block.data()), block.size() * sizeof(int32_t))) {
+                throw runtime_error("Файл показателей обрезан: " + path);
+            }
+            for (uint32_t r = 0; r < header[1]; ++r) {
+                out << header[0];
+                for (uint32_t c = 0; c < columns; ++c) out << "," << block[c * header[1] + r];
+                out << "\n";
+            }
+            total += header[1];
+        }
+        return total;
+    }
+
+private:
+    FILE* file;  ///< Открытый файл
+    bool csv;    ///< Писать CSV вместо блоков
+    mutex lock;  ///< Защищает запись блоков из разных прогонов
+};
+
+/**
+ * @brief Запись показателей одного прогона по дням в заранее выделенные столбцы.
+ * @details Столбцы выделяются один раз; record только раскладывает строку по столбцам,
+ * поэтому запись можно не выключать даже в прогонах на 100 тысяч дней и в сериях
+ * Монте-Карло. Заполненные столбцы одним блоком уходят в MetricsFile.
+ */
+class MetricsRecorder {
+public:
+    static constexpr size_t DEFAULT_ROWS = 4096; ///< Строк в блоке по умолчанию
+
+    /**
+     * @param target Файл показателей; должен пережить запись
+     * @param runNumber Номер прогона в файле
+     * @param rows Строк в блоке
+     */
+    MetricsRecorder(MetricsFile& target, uint32_t runNumber, size_t rows = DEFAULT_ROWS)
+        : file(target), run(runNumber), capacity(max<size_t>(rows, 1)), columns(METRIC_COUNT * capacity) {}
+    ~MetricsRecorder() {
+        flush();
+    }
+    MetricsRecorder(const MetricsRecorder&) = delete;
+    MetricsRecorder& operator=(const MetricsRecorder&) = delete;
+
+    /**
+     * @brief Добавляет строку дня; заполненный блок дописывается в файл.
+     */
+    void record(const DayMetrics& row) {
+        for (int c = 0; c < METRIC_COUNT; ++c) columns[c * capacity + count] = row[c];
+        if (++count == capacity) flush();
+    }
+    /**
+     * @brief Дописывает накопленные строки в файл.
+     */
+    void flush() {
+        if (count == 0) return;
+        file.writeBlock(run, columns.data(), capacity, static_cast<uint32_t>(count));
+        count = 0;
+    }
+
+private:
+    MetricsFile& file;       ///< Куда уходят блоки
+    uint32_t run;            ///< Номер прогона
+    size_t capacity;         ///< Строк в блоке
+    vector<int32_t> columns; ///< Столбцы подряд, по capacity значений
+    size_t count = 0;        ///< Строк в текущем блоке
+};
+
+/**
+ * @brief Способ определения смерти от старости.
+ */
+enum class AgingMode {
+    CALENDAR,   ///< День смерти разыгрывается заранее и хранится в DeathCalendar
+    DAILY_ROLL  ///< Прежний ежедневный бросок для каждого животного старше 60 дней
+};
+
+/**
+ * @brief Способ распространения вируса в Enclosure::spreadVirus.
+ */
+enum class SpreadMode {
+    BINOMIAL, ///< Число заражений из биномиального распределения, жертвы выбираются равномерно
+    LEGACY    ///< Прежний перебор с начала списка; для сверки с прошлыми результатами
+};
+
+/**
+ * @brief Класс для представления вольера.
+ */
+class Enclosure {
+public:
+    Animal::Climate climate; ///< Климат вольера
+    int capacity;            ///< Вместимость вольера
+    AnimalStore animals;     ///< Животные вольера (колоночное хранилище)
+    int dailyCost;           ///< Ежедневные расходы на содержание вольера
+    int level;               ///< Уровень вольера
+    Zoo* zoo;                ///< Зоопарк-владелец (nullptr для временного вольера)
+    int index;               ///< Номер вольера в зоопарке
+    Rng agingRng;            ///< Поток для смерти от старости
+    Rng infectionRng;        ///< Поток для заражения случайного животного
+    Rng spreadRng;           ///< Поток для распространения вируса
+
+    /**
+     * @brief Конструктор для создания нового вольера.
+     * @param c Климат вольера
+     * @param cap Вместимость вольера
+     */
+    Enclosure(Animal::Climate c, int cap)
+        : climate(c), capacity(cap), level(1), zoo(nullptr), index(-1) {
+        dailyCost = calculateDailyCost();
+    }
+    /**
+     * @brief Реестр животных зоопарка-владельца.
+     */
+    AnimalRegistry& registry();
+    /**
+     * @brief Поток размножения зоопарка-владельца.
+     */
+    Rng& breedingRng();
+    /**
+     * @brief Текущий день зоопарка-владельца.
+     */
+    int today() const;
+    /**
+     * @brief Выдаёт вольеру собственные потоки случайных чисел.
+     * @param seed Зерно зоопарка
+     */
+    void seedRng(uint64_t seed) {
+        agingRng = Rng::stream(seed, RNG_AGING, index);
+        infectionRng = Rng::stream(seed, RNG_INFECTION, index);
+        spreadRng = Rng::stream(seed, RNG_SPREAD, index);
+    }
+    /**
+     * @brief Проверяет, можно ли добавить животное в вольер.
+     * @param animal Животное для добавления
+     * @return true, если животное можно добавить, иначе false.
+     */
+    bool canAddAnimal(const Animal& animal) {
+        if (animals.size() >= capacity) return false; // Проверка вместимости
+        if (animal.climate() != climate) return false;  // Проверка климата
+
+        // Проверка типа животного
+        if (climate == Animal::OCEAN && !animal.isAquatic()) {
+            ZOO_LOG(LogLevel::INFO, "Только водоплавающие животные могут находиться в вольере с климатом 'Океан'!\n");
+            return false;
+        }
+        if (climate != Animal::OCEAN && animal.isAquatic()) {
+            ZOO_LOG(LogLevel::INFO, "Водоплавающие животные могут находиться только в вольерах с климатом 'Океан'!\n");
+            return false;
+        }
+
+        // Проверка совместимости хищников и травоядных
+        if (!animals.empty()) {
+            bool hasCarnivore = animals.isCarnivore(0);
+            if (hasCarnivore != animal.isCarnivore()) {
+                ZOO_LOG(LogLevel::INFO, "Нельзя смешивать хищников и травоядных в одном вольере!\n");
+                return false;
+            }
+        }
+
+        return true;
+    }
+    /**
+     * @brief Добавляет животное в вольер, если это возможно.
+     * @param animal Животное для добавления
+     * @return Дескриптор добавленного животного или NO_ANIMAL.
+     */
+    AnimalId addAnimal(const Animal& animal) {
+        if (!canAddAnimal(animal)) return NO_ANIMAL;
+        return insertAnimal(animal);
+    }
+    /**
+     * @brief Помещает животное в вольер без проверок и выдаёт ему дескриптор.
+     * @param animal Животное для добавления
+     * @return Дескриптор добавленного животного.
+     */
+    AnimalId insertAnimal(const Animal& animal) {
+        AnimalId id = registry().create(index, static_cast<uint32_t>(animals.size()));
+        animals.push(animal, id, today()); // Добавляем животное в конец хранилища
+        scheduleDeath(animals.size() - 1);
+        return id;
+    }
+    /**
+     * @brief Помещает блок сгенерированных животных в вольер без проверок.
+     * @details Дескрипторы выдаются одним блоком, столбцы хранилища растут один раз.
+     * @param n Количество животных
+     * @param make make(k) возвращает k-е животное блока (см. AnimalStore::appendBlock)
+     */
+    template <typename Make>
+    void insertAnimals(size_t n, Make make) {
+        size_t first = animals.size();
+        AnimalId firstId = registry().createBlock(index, static_cast<uint32_t>(first), static_cast<uint32_t>(n));
+        animals.appendBlock(n, firstId, today(), make);
+        for (size_t i = first; i < animals.size(); ++i) {
+            scheduleDeath(i);
+        }
+    }
+    /**
+     * @brief Разыгрывает день смерти животного от старости и ставит его в календарь зоопарка.
+     * @details Ничего не делает, если зоопарк использует AgingMode::DAILY_ROLL.
+     * @param row Строка животного в хранилище
+     */
+    void scheduleDeath(size_t row);
+    /**
+     * @brief Записывает событие вольера в журнал зоопарка.
+     * @param type Тип события
+     * @param animal Животное
+     * @param amount Изменение денег
+     * @param detail Причина смерти или 0
+     */
+    void logEvent(EventType type, AnimalId animal, int amount = 0, uint8_t detail = 0);
+    /**
+     * @brief Подходят ли животные строк i и j для размножения: разного пола и оба старше 5 дней.
+     */
+    bool isBreedingPair(size_t i, size_t j, int day) const {
+        return animals.gender(i) != animals.gender(j) && animals.age(i, day) > 5 && animals.age(j, day) > 5;
+    }
+    /**
+     * @brief Могут ли животные строк parent1 и parent2 дать потомство сегодня:
+     * оба есть, это разные животные и они образуют пару (isBreedingPair).
+     */
+    bool canBreed(size_t parent1, size_t parent2) const {
+        return parent1 < animals.size() && parent2 < animals.size() && parent1 != parent2
+            && isBreedingPair(parent1, parent2, today());
+    }
+    /**
+     * @brief Рождает потомство пары без вопросов игроку и записывает действие в журнал.
+     * @param parent1 Строка первого родителя
+     * @param parent2 Строка второго родителя
+     * @param nameOffspring Имя потомка по его виду (спрашивается у игрока или берётся из журнала)
+     * @return Имена рождённых потомков; пусто, если пара не подходит (canBreed) или вольер полон.
+     */
+    vector<string> breedPair(size_t parent1, size_t parent2, const function<string(SpeciesId)>& nameOffspring);
+    /**
+     * @brief Ищет первую разнополую пару животных старше 5 дней.
+     * @param day Текущий день зоопарка
+     * @param parent1 Сюда записывается строка первого родителя
+     * @param parent2 Сюда записывается строка второго родителя
+     * @return true, если пара найдена.
+     */
+    bool findBreedingPair(int day, int& parent1, int& parent2) const {
+        for (size_t i = 0; i < animals.size(); ++i) {
+            if (animals.age(i, day) <= 5) continue;
+            for (size_t j = i + 1; j < animals.size(); ++j) {
+                if (isBreedingPair(i, j, day)) {
+                    parent1 = static_cast<int>(i);
+                    parent2 = static_cast<int>(j);
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+    /**
+     * @brief Размножает животных в вольере.
+     * @param zoo Ссылка на объект зоопарка
+     */
+    void breedAnimals(Zoo& zoo) {
+        if (animals.size() < 2) {
+            cout << "Недостаточно животных для размножения!\n";
+            return;
+        }
+
+        // Находим разнополую пару
+        int parent1 = -1;
+        int parent2 = -1;
+
+        // Вывод списка животных в вольере
+        cout << "Животные в вольере:\n";
+        for (size_t i = 0; i < animals.size(); ++i) {
+            cout << i + 1 << ". " << animals.name(i)
+                << ", Пол: " << (animals.gender(i) == 'M' ? "М" : "Ж")
+                << ", Возраст: " << animals.age(i, today()) << " дней\n";
+        }
+
+        // Запрос выбора первого животного
+        int choice1 = getIntegerInput("Введите номер первого животного: ");
+        if (choice1 <= 0 || choice1 > animals.size()) {
+            cout << "Неверный номер первого животного!\n";
+            return;
+        }
+
+        // Запрос выбора второго животного
+        int choice2 = getIntegerInput("Введите номер второго животного: ");
+        if (choice2 <= 0 || choice2 > animals.size() || choice1 == choice2) {
+            cout << "Неверный номер второго животного или вы выбрали одно и то же животное!\n";
+            return;
+        }
+
+        int day = today();
+        if (!findBreedingPair(day, parent1, parent2)) {
+            cout << "Не удалось найти подходящую пару для размножения!\n";
+            return;
+        }
+
+        // Копии родителей: добавление потомков может перераспределить столбцы
+        const Animal mother = animals.get(parent1, day);
+        const Animal father = animals.get(parent2, day);
+
+        // Выводим информацию о найденной паре
+        cout << "Найдена пара для размножения:\n";
+        cout << "1. " << mother.name << ", Вид: " << mother.speciesName() << "\n";
+        cout << "2. " << father.name << ", Вид: " << father.speciesName() << "\n";
+
+        // Запрос подтверждения у пользователя
+        cout << "Хотите размножить этих животных?\n";
+        cout << "1. Да\n2. Нет\n";
+        int confirm = getIntegerInput("Ваш выбор: ");
+        if (confirm != 1) {
+            cout << "Размножение отменено.\n";
+            return;
+        }
+
+        breedPair(parent1, parent2, [](SpeciesId species) {
+            // Запрашиваем имя нового животного у пользователя
+            cout << "Введите имя для нового животного (" << SpeciesTable::instance().name(species) << "): ";
+            return getLineInput();
+        });
+    }
+    /**
+     * @brief Удаляет животное из вольера.
+     * @param id Дескриптор животного
+     * @return true, если животное было в этом вольере и удалено.
+     */
+    bool removeAnimal(AnimalId id) {
+        const AnimalRegistry::Slot* slot = registry().find(id);
+        if (!slot || slot->enclosure != index) return false;
+        animals.erase(slot->row, registry());
+        return true;
+    }
+    /**
+     * @brief Заражает случайное животное в вольере.
+     */
+    void infectRandomAnimal() {
+        if (animals.empty()) return; // Если в вольере нет животных, ничего не делаем
+
+        for (size_t i = 0; i < animals.size(); ++i) {
+            if (!animals.isInfected(i) && infectionRng.chance(30)) { // 30% шанс заражения
+                animals.setInfected(i, true);
+                logEvent(EventType::INFECTION, animals.ids[i]);
+                ZOO_LOG(LogLevel::TRACE, "Животное \"" << animals.name(i) << "\" заразилось терановирусом!\n");
+                ZOO_COUNT(COUNTER_SCANNED, i + 1);
+                return; // Заражаем только одно животное за раз
+            }
+        }
+        ZOO_COUNT(COUNTER_SCANNED, animals.size());
+    }
+    /**
+    * @brief Распространяет вирус среди животных в вольере.
+    * @param mode Способ распространения
+    * @return Сколько животных умерло от вируса.
+    */
+    int spreadVirus(SpreadMode mode = SpreadMode::BINOMIAL) {
+        int infectedCount = animals.counts().infected;
+        if (static_cast<size_t>(infectedCount) > animals.size() / 2) {
+            // Если больше половины животных заражены, начинают умирать
+            vector<string> deadAnimals; // Имена собираются, только если уведомления кто-то увидит
+            bool notify = simSink().enabled(LogLevel::NOTICE);
+            int died = 0;
+            size_t alive = animals.size();
+            size_t i = 0;
+            for (; i < animals.size() && static_cast<size_t>(infectedCount) > alive / 2; ++i) {
+                if (animals.isInfected(i) && spreadRng.below(2) == 0) {
+                    if (notify) deadAnimals.push_back(animals.name(i));
+                    died++;
+                    logEvent(EventType::DEATH, animals.ids[i], 0, static_cast<uint8_t>(DeathCause::VIRUS));
+                    animals.markDead(i);
+                    alive--;
+                    infectedCount--;
+                }
+            }
+            ZOO_COUNT(COUNTER_SCANNED, i);
+            animals.removeDead(registry());
+
+            // Вывод уведомлений о смерти
+            if (!deadAnimals.empty()) {
+                ZOO_LOG(LogLevel::NOTICE, "\n--- Уведомления ---\n");
+                for (const string& name : deadAnimals) {
+                    ZOO_LOG(LogLevel::NOTICE, "Животное \"" << name << "\" умерло от терановируса.\n");
+                }
+            }
+            return died;
+        }
+        // Иначе каждое больное животное заражает ещё до двух
+        if (mode == SpreadMode::LEGACY) spreadLegacy();
+        else spreadBinomial(infectedCount);
+        return 0;
+    }
+    /**
+    * @brief Распространение вируса: каждый из заражённых на начало шага контактирует с каждым
+    * здоровым животным с шансом 30% и заражает не больше двух.
+    * @details Число заражений от одного больного — min(2, Binom(S, 0.3)), где S — текущее число
+    * здоровых; оно разыгрывается одним случайным числом, а жертвы выбираются равномерно из
+    * здоровых. Итого O(n) на вольер вместо O(заражённых × n) и без перекоса к началу списка.
+    * @param infectors Число заражённых на начало шага
+    */
+    void spreadBinomial(int infectors) {
+        const double P = 0.3, Q = 1.0 - P; // 30% шанс заражения при контакте
+        vector<uint32_t> susceptible;
+        susceptible.reserve(animals.size() - infectors);
+        for (size_t i = 0; i < animals.size(); ++i) {
+            if (!animals.isInfected(i)) susceptible.push_back(static_cast<uint32_t>(i));
+        }
+        ZOO_COUNT(COUNTER_SCANNED, animals.size());
+        for (int k = 0; k < infectors && !susceptible.empty(); ++k) {
+            size_t healthy = susceptible.size();
+            double none = pow(Q, static_cast<double>(healthy));        // P(Binom = 0)
+            double one = healthy * P * pow(Q, static_cast<double>(healthy - 1)); // P(Binom = 1)
+            double u = spreadRng.uniform();
+            size_t infections = u < none ? 0 : (u < none + one ? 1 : 2);
+            infections = min(infections, healthy);
+            for (size_t n = 0; n < infections; ++n) {
+                uint32_t pick = spreadRng.below(static_cast<uint32_t>(susceptible.size()));
+                uint32_t row = susceptible[pick];
+                susceptible[pick] = susceptible.back();
+                susceptible.pop_back();
+                animals.setInfected(row, true);
+                logEvent(EventType::INFECTION, animals.ids[row]);
+                ZOO_LOG(LogLevel::TRACE, "Животное \"" << animals.name(row) << "\" заразилось терановирусом!\n");
+            }
+        }
+    }
+    /**
+    * @brief Прежнее распространение вируса: каждый больной перебирает список с начала.
+    * @details O(заражённых × n); заражает преимущественно животных в начале списка,
+    * а заражённые в этот же день тоже успевают заразить других, если стоят дальше по списку.
+    */
+    void spreadLegacy() {
+        ZOO_COUNT(COUNTER_SCANNED, animals.size());
+        for (size_t i = 0; i < animals.size(); ++i) {
+            if (animals.isInfected(i)) {
+                int infections = 0;
+                for (size_t j = 0; j < animals.size() && infections < 2; ++j) {
+                    ZOO_COUNT(COUNTER_SCANNED, 1);
+                    if (!animals.isInfected(j) && spreadRng.chance(30)) { // 30% шанс заражения
+                        animals.setInfected(j, true);
+                        logEvent(EventType::INFECTION, animals.ids[j]);
+                        infections++;
+                        ZOO_LOG(LogLevel::TRACE, "Животное \"" << animals.name(j) << "\" заразилось терановирусом!\n");
+                    }
+                }
+            }
+        }
+    }
+    /**
+     * @brief Дневной проход по вольеру: смерть от старости, заражение и распространение вируса.
+     * @details Возраст выводится из дня рождения, поэтому животных больше не нужно старить.
+     * При AgingMode::CALENDAR умершие от старости уже удалены Zoo::processScheduledDeaths,
+     * и проход сводится к заражению одного животного и распространению вируса.
+     * При AgingMode::DAILY_ROLL броски старости и заражение делаются за один обход и дают
+     * то же состояние, что и последовательность броски → removeDead → infectRandomAnimal():
+     * каждая строка получает те же случайные числа из потоков вольера в том же порядке.
+     * Распространение вируса остаётся отдельным шагом, потому что его ветка зависит
+     * от итогового числа заражённых; число берётся из счётчиков хранилища.
+     * @param spread Способ распространения вируса
+     * @param aging Способ определения смерти от старости
+     * @return Итоги прохода.
+     */
+    DayTally tick(SpreadMode spread, AgingMode aging) {
+        DayTally tally;
+        if (aging == AgingMode::DAILY_ROLL) {
+            ZOO_PROFILE_PHASE(PHASE_AGING); // Заражение идёт в том же обходе
+            int endOfDay = today() + 1; // Возраст, которого животное достигает в этот день
+            bool infectedOne = false; // Заражаем только одно животное за день
+            animals.removeIf(registry(), [&](size_t i) {
+                if (Animal::diesOfOldAge(animals.age(i, endOfDay), agingRng)) {
+                    logEvent(EventType::DEATH, animals.ids[i], 0, static_cast<uint8_t>(DeathCause::OLD_AGE));
+                    ZOO_LOG(LogLevel::NOTICE, "Животное \"" << animals.name(i) << "\" умерло от старости.\n");
+                    tally.oldAgeDeaths++;
+                    return true;
+                }
+                if (!infectedOne && !animals.isInfected(i) && infectionRng.chance(30)) { // 30% шанс заражения
+                    animals.setInfected(i, true);
+                    logEvent(EventType::INFECTION, animals.ids[i]);
+                    ZOO_LOG(LogLevel::TRACE, "Животное \"" << animals.name(i) << "\" заразилось терановирусом!\n");
+                    infectedOne = true;
+                }
+                return false;
+            });
+        }
+        else {
+            ZOO_PROFILE_PHASE(PHASE_INFECTION);
+            infectRandomAnimal();
+        }
+        {
+            ZOO_PROFILE_PHASE(PHASE_SPREAD);
+            tally.virusDeaths = spreadVirus(spread);
+        }
+        tally.infected = animals.counts().infected;
+        tally.animals = animals.counts().animals;
+        return tally;
+    }
+    /**
+     * @brief Стоимость улучшения вольера до следующего уровня.
+     */
+    int upgradeCost() const {
+        return capacity * 5 * (level + 1);
+    }
+    /**
+    * @brief Улучшает вольер до следующего уровня.
+    * @param baseUpgradeCost Базовая стоимость улучшения
+    * @return true, если улучшение успешно, иначе false.
+    */
+    bool upgrade(int baseUpgradeCost) {
+        if (level >= 3) { // Ограничение на максимальный уровень
+            ZOO_LOG(LogLevel::INFO, "Достигнут максимальный уровень улучшения!\n");
+            return false;
+        }
+        capacity *= 2; // Увеличиваем вместимость в два раза
+        dailyCost += calculateDailyCost() / 2; // Увеличиваем ежедневные расходы
+        level++; // Повышаем уровень
+        return true;
+    }
+    /**
+     * @brief Рассчитывает стоимость строительства вольера.
+     * @return Стоимость вольера в монетах.
+     */
+    int calculateCost() const {
+        int baseCost = 100; // Базовая стоимость
+        int cost = baseCost;
+
+        // Модификаторы стоимости:
+        cost += capacity * 10; // Чем больше вместимость, тем дороже
+        cost += static_cast<int>(climate) * 50; // Разные климаты влияют на стоимость
+
+        return max(cost, 150); // Минимальная стоимость = 150
+    }
+    /**
+     * @brief Рассчитывает ежедневные расходы на содержание вольера.
+     * @return Ежедневные расходы в монетах.
+     */
+    int calculateDailyCost() const {
+        int baseDailyCost = 10; // Базовые ежедневные расходы
+        int dailyCost = baseDailyCost;
+
+        // Модификаторы расходов:
+        dailyCost += capacity / 10; // Большая вместимость увеличивает расходы
+        dailyCost += static_cast<int>(climate) * 5; // Разные климаты влияют на расходы
+
+        // Учет водоплавающих животных
+        dailyCost += animals.counts().aquatic * 10; // Дополнительные расходы за каждое водоплавающее животное
+
+        return max(dailyCost, 10); // Минимальные расходы = 10
+    }
+};
+/**
+ * @brief Класс для представления сотрудника зоопарка.
+ */
+class Employee {
+public:
+    string name;         ///< Имя сотрудника
+    string position;     ///< Должность сотрудника
+    int salary;          ///< Зарплата сотрудника
+    int maxAnimals;      ///< Максимальное количество животных, за которыми может ухаживать сотрудник
+    int currentAnimals;  ///< Текущее количество животных, за которыми ухаживает сотрудник
+    /**
+     * @brief Конструктор для создания нового сотрудника.
+     * @param n Имя сотрудника
+     * @param pos Должность
+     * @param sal Зарплата
+     * @param max Максимальное количество животных
+     */
+    Employee(string n, string pos, int sal, int max)
+        : name(n), position(pos), salary(sal), maxAnimals(max), currentAnimals(0) {}
+};
+/**
+ * @brief Описание должности, на которую можно нанять сотрудника.
+ */
+struct EmployeePosition {
+    const char* title; ///< Название должности
+    int salary;        ///< Зарплата
+    int maxAnimals;    ///< Сколько животных обслуживает
+};
+/**
+ * @brief Должности для найма (номер в меню = индекс + 1).
+ */
+const EmployeePosition EMPLOYEE_POSITIONS[] = {
+    { "Уборщик", 80, 20 },
+    { "Ветеринар", 150, 10 },
+    { "Кормилец", 100, 30 }
+};
+const int EMPLOYEE_POSITION_COUNT = 3; ///< Количество должностей для найма
+/**
+ * @brief Случайное событие дня.
+ */
+struct RandomEvent {
+    const char* title;   ///< Название
+    const char* message; ///< Сообщение о последствиях
+    int popularity;      ///< Изменение популярности
+    int money;           ///< Изменение денег
+};
+/**
+ * @brief Случайные события: сначала положительные, затем столько же отрицательных.
+ */
+const RandomEvent RANDOM_EVENTS[] = {
+    { "Знаменитый посетитель", "Знаменитый посетитель: Популярность увеличена на 10.", 10, 0 },
+    { "Пожертвование от спонсора", "Пожертвование от спонсора: Получено 500 монет.", 0, 500 },
+    { "Редкий гость", "Редкий гость: Популярность увеличена на 5.", 5, 0 },
+    { "День защиты животных", "День защиты животных: Популярность увеличена на 15.", 15, 0 },
+    { "Благотворительный фонд", "Благотворительный фонд: Получено 1000 монет.", 0, 1000 },
+    { "Побег животного", "Побег животного: Популярность уменьшена на 10.", -10, 0 },
+    { "Протечка в системе водоснабжения", "Протечка в системе водоснабжения: Потеряно 300 монет.", 0, -300 },
+    { "Конфликт сотрудников", "Конфликт сотрудников: Популярность уменьшена на 5.", -5, 0 },
+    { "Пожар в зоопарке", "Пожар в зоопарке: Популярность уменьшена на 15, потеряно 500 монет.", -15, -500 },
+    { "Штраф от экологов", "Штраф от экологов: Потеряно 200 монет.", 0, -200 }
+};
+const int RANDOM_EVENTS_PER_KIND = 5; ///< Положительных событий (и отрицательных) в RANDOM_EVENTS
+/**
+ * @brief Генерирует случайное животное.
+ * @param rng Генератор случайных чисел
+ * @return Случайное животное.
+ */
+Animal generateRandomAnimal(Rng& rng); // Предварительное объявление функции
+
+/**
+ * @brief Класс для представления зоопарка.
+ */
+class Zoo {
+public:
+    string name;                     ///< Название зоопарка
+    int money, food, popularity;     ///< Деньги, количество еды и популярность зоопарка
+    int day;                         ///< Текущий день
+    int animalsBoughtToday;          ///< Счётчик купленных сегодня животных
+    vector<Enclosure> enclosures;    ///< Список вольеров 
+    AnimalRegistry registry;         ///< Реестр дескрипторов животных
+    list<Employee> employees;        ///< Список сотрудников (меняется через hireEmployee/fireEmployee)
+    vector<Animal> animalMarket;     ///< Пул животных для покупки
+    uint64_t seed;                   ///< Зерно всех генераторов зоопарка
+    Rng eventsRng;                   ///< Поток случайных событий
+    Rng marketRng;                   ///< Поток рынка животных
+    Rng feedingRng;                  ///< Поток гибели от голода
+    Rng popularityRng;               ///< Поток колебаний популярности
+    Rng breedingRng;                 ///< Поток размножения
+    /**
+     * @brief Счётчики погибших животных по причинам с начала игры.
+     */
+    struct DeathCounts {
+        int oldAge = 0;      ///< От старости
+        int virus = 0;       ///< От терановируса
+        int starvation = 0;  ///< От голода
+    };
+    DeathCounts deaths;              ///< Погибшие животные
+    AnimalCounts animalCounts;       ///< Счётчики животных всех вольеров
+    int payroll = 0;                 ///< Сумма зарплат всех сотрудников
+    /**
+     * @brief Способ обхода животных в nextDay.
+     */
+    enum class TickMode {
+        FUSED,      ///< Один проход на вольер (Enclosure::tick)
+        MULTI_PASS  ///< Отдельный проход на каждый шаг; эталон для сверки
+    };
+    TickMode tickMode = TickMode::FUSED; ///< Способ обхода животных
+    SpreadMode spreadMode = SpreadMode::BINOMIAL; ///< Способ распространения вируса
+    AgingMode agingMode = AgingMode::CALENDAR;    ///< Способ определения смерти от старости (см. setAgingMode)
+    DeathCalendar deathCalendar;     ///< Запланированные смерти от старости
+    EventLog events;                 ///< Журнал событий
+    ActionJournal journal;           ///< Журнал действий игрока (ведётся, если открыт)
+    MetricsRecorder* metrics = nullptr; ///< Запись показателей по дням или nullptr
+    int infectionsToday = 0;         ///< Новых заражений за текущий день
+    /**
+     * @brief Конструктор для создания нового зоопарка.
+     * @param n Название зоопарка
+     * @param initialMoney Начальный капитал
+     * @param s Зерно генераторов случайных чисел; одинаковое зерно даёт одинаковую игру
+     * @param eventCapacity Ёмкость журнала событий в записях
+     */
+    Zoo(string n, int initialMoney, uint64_t s = 0, size_t eventCapacity = EventLog::DEFAULT_CAPACITY)
+        : name(n), money(initialMoney), food(0), popularity(50), day(1), animalsBoughtToday(0), seed(s),
+        eventsRng(Rng::stream(s, RNG_EVENTS)), marketRng(Rng::stream(s, RNG_MARKET)),
+        feedingRng(Rng::stream(s, RNG_FEEDING)), popularityRng(Rng::stream(s, RNG_POPULARITY)),
+        breedingRng(Rng::stream(s, RNG_BREEDING)), events(eventCapacity) {
+        generateAnimalMarket(); // Инициализация пула животных
+    }
+    /**
+     * @brief Копирует зоопарк целиком, включая состояние генераторов.
+     * @details Столбцы животных, части реестра и корзины календаря смертей копируются
+     * при записи (SharedColumn): копия разделяет их с исходным зоопарком, пока не изменит.
+     * Вольеры ссылаются на зоопарк-владельца, поэтому копия перепривязывает их к себе.
+     * Журнал действий и запись показателей не копируются: копия их не ведёт.
+     */
+    Zoo(const Zoo& other)
+        : name(other.name), money(other.money), food(other.food), popularity(other.popularity),
+        day(other.day), animalsBoughtToday(other.animalsBoughtToday), enclosures(other.enclosures),
+        registry(other.registry), employees(other.employees), animalMarket(other.animalMarket),
+        seed(other.seed), eventsRng(other.eventsRng), marketRng(other.marketRng),
+        feedingRng(other.feedingRng), popularityRng(other.popularityRng),
+        breedingRng(other.breedingRng), deaths(other.deaths), animalCounts(other.animalCounts),
+        payroll(other.payroll), tickMode(other.tickMode), spreadMode(other.spreadMode),
+        agingMode(other.agingMode), deathCalendar(other.deathCalendar), events(other.events) {
+        for (auto& enc : enclosures) {
+            enc.zoo = this;
+            enc.animals.attachCounts(&animalCounts);
+        }
+    }
+    Zoo& operator=(const Zoo&) = delete;
+    /**
+     * @brief Перезапускает все генераторы зоопарка и вольеров с новым зерном.
+     * @param s Новое зерно
+     */
+    void reseed(uint64_t s) {
+        reseedStreams(s);
+        rescheduleDeaths(); // Дни смерти разыграны старыми потоками
+    }
+    /**
+     * @brief Перезапускает генераторы с новым зерном, сохраняя разыгранные дни смерти.
+     * @param s Новое зерно
+     */
+    void reseedStreams(uint64_t s) {
+        seed = s;
+        eventsRng = Rng::stream(s, RNG_EVENTS);
+        marketRng = Rng::stream(s, RNG_MARKET);
+        feedingRng = Rng::stream(s, RNG_FEEDING);
+        popularityRng = Rng::stream(s, RNG_POPULARITY);
+        breedingRng = Rng::stream(s, RNG_BREEDING);
+        for (auto& enc : enclosures) {
+            enc.seedRng(s);
+        }
+    }
+    /**
+     * @brief Создаёт развилку зоопарка для проверки "что будет, если".
+     * @details Развилка разделяет с зоопарком все данные животных и копирует только то,
+     * что сама изменит, поэтому десятки развилок большого зоопарка почти не занимают памяти.
+     * Развилка 0 продолжает генераторы зоопарка; остальные получают зерно seed и номера
+     * развилки. Разыгранные дни смерти сохраняются, иначе перерасчёт скопировал бы все
+     * столбцы. Пока развилки живы, исходный зоопарк можно читать, но не менять.
+     * @param branch Номер развилки
+     * @return Новый зоопарк.
+     */
+    unique_ptr<Zoo> fork(uint32_t branch) const {
+        unique_ptr<Zoo> copy = make_unique<Zoo>(*this);
+        if (branch != 0) copy->reseedStreams(Rng::stream(seed, RNG_FORK, branch).next());
+        return copy;
+    }
+    /**
+     * @brief Делает собственными все данные, общие с развилками или исходным зоопарком.
+     */
+    void unshare() {
+        registry.unshare();
+        deathCalendar.unshare();
+        for (auto& enc : enclosures) enc.animals.unshare();
+    }
+    /**
+     * @brief Объём данных животных, общих с другими копиями зоопарка.
+     * @return Количество байт.
+     */
+    size_t sharedBytes() const {
+        size_t bytes = registry.sharedBytes() + deathCalendar.sharedBytes();
+        for (const auto& enc : enclosures) bytes += enc.animals.sharedBytes();
+        return bytes;
+    }
+    /**
+     * @brief Меняет способ определения смерти от старости.
+     * @param mode Новый способ; при переходе на календарь дни смерти разыгрываются для всех животных
+     */
+    void setAgingMode(AgingMode mode) {
+        agingMode = mode;
+        rescheduleDeaths();
+    }
+    /**
+     * @brief Заново разыгрывает дни смерти всех животных.
+     */
+    void rescheduleDeaths() {
+        deathCalendar.clear();
+        for (auto& enc : enclosures) {
+            for (size_t i = 0; i < enc.animals.size(); ++i) {
+                enc.scheduleDeath(i);
+            }
+        }
+    }
+    /**
+     * @brief Удаляет животных, чья смерть от старости запланирована на сегодня.
+     * @return Количество умерших.
+     */
+    int processScheduledDeaths() {
+        const SharedColumn<AnimalId>& due = deathCalendar.due(day);
+        ZOO_COUNT(COUNTER_SCANNED, due.size());
+        int died = 0;
+        for (AnimalId id : due) {
+            size_t row;
+            Enclosure* enc = findAnimal(id, row);
+            // Животное продано или дескриптор уже выдан другому
+            if (!enc || enc->animals.deathDays[row] != static_cast<uint32_t>(day)) continue;
+            logEvent(EventType::DEATH, id, enc->index, 0, static_cast<uint8_t>(DeathCause::OLD_AGE));
+            ZOO_LOG(LogLevel::NOTICE, "Животное \"" << enc->animals.name(row) << "\" умерло от старости.\n");
+            enc->animals.erase(row, registry);
+            died++;
+        }
+        deathCalendar.clearDay(day);
+        return died;
+    }
+    /**
+     * @brief Строит новый вольер и привязывает его к зоопарку.
+     * @param climate Климат вольера
+     * @param capacity Вместимость вольера
+     * @return Ссылка на построенный вольер.
+     */
+    Enclosure& addEnclosure(Animal::Climate climate, int capacity) {
+        enclosures.emplace_back(climate, capacity); //emplace back создаёт объект непосредственно в контейнере, избегая лишних копирований
+        Enclosure& enc = enclosures.back();
+        enc.zoo = this;
+        enc.animals.attachCounts(&animalCounts);
+        enc.index = static_cast<int>(enclosures.size()) - 1;
+        enc.seedRng(seed);
+        return enc;
+    }
+    /**
+     * @brief Нанимает сотрудника.
+     * @param name Имя
+     * @param position Должность
+     * @param salary Зарплата
+     * @param maxAnimals Сколько животных обслуживает
+     * @return Ссылка на нового сотрудника.
+     */
+    Employee& hireEmployee(const string& name, const string& position, int salary, int maxAnimals) {
+        employees.emplace_back(name, position, salary, maxAnimals);
+        payroll += salary;
+        return employees.back();
+    }
+    /**
+     * @brief Увольняет сотрудника.
+     * @param it Сотрудник в списке employees
+     */
+    void fireEmployee(list<Employee>::iterator it) {
+        payroll -= it->salary;
+        employees.erase(it);
+    }
+    /**
+     * @brief Проверяет счётчики животных и сумму зарплат пересчётом с нуля.
+     * @return true, если все счётчики совпадают с пересчётом.
+     */
+    bool countsConsistent() const {
+        AnimalCounts total;
+        for (const auto& enc : enclosures) {
+            AnimalCounts actual = enc.animals.recount();
+            if (!(actual == enc.animals.counts())) return false;
+            total += actual;
+        }
+        int salaries = 0;
+        for (const auto& emp : employees) salaries += emp.salary;
+        return total == animalCounts && salaries == payroll;
+    }
+    /**
+     * @brief Находит вольер, в котором живёт животное.
+     * @param id Дескриптор животного
+     * @param row Сюда записывается строка животного в хранилище вольера
+     * @return Вольер или nullptr, если животного больше нет.
+     */
+    Enclosure* findAnimal(AnimalId id, size_t& row) {
+        const AnimalRegistry::Slot* slot = registry.find(id);
+        if (!slot) return nullptr;
+        row = slot->row;
+        return &enclosures[slot->enclosure];
+    }
+    /**
+     * @brief Возвращает имя животного по дескриптору.
+     * @param id Дескриптор животного
+     * @return Имя или пустая строка, если животного больше нет в зоопарке.
+     */
+    string animalName(AnimalId id) const {
+        const AnimalRegistry::Slot* slot = registry.find(id);
+        if (!slot) return "";
+        return enclosures[slot->enclosure].animals.name(slot->row);
+    }
+    /**
+     * @brief Генерирует пул животных для покупки.
+     */
+    void generateAnimalMarket() {
+        const int MAX_ANIMALS_IN_MARKET = 10;
+        animalMarket.clear();
+        for (int i = 0; i < MAX_ANIMALS_IN_MARKET; ++i) {
+            animalMarket.push_back(generateRandomAnimal(marketRng));
+        }
+    }
+    /**
+     * @brief Сброс счётчика купленных животных за текущий день.
+     */
+    void resetDailyCounters() {
+        animalsBoughtToday = 0; // Сбрасываем счетчик в начале дня
+        infectionsToday = 0;
+    }
+    /**
+     * @brief Записывает событие текущего дня в журнал.
+     * @param type Тип события
+     * @param animal Животное или NO_ANIMAL
+     * @param enclosure Номер вольера или -1
+     * @param amount Изменение денег
+     * @param detail Причина смерти или номер случайного события
+     */
+    void logEvent(EventType type, AnimalId animal, int enclosure = -1, int amount = 0, uint8_t detail = 0) {
+        if (type == EventType::INFECTION) infectionsToday++;
+        events.record({ static_cast<uint32_t>(day), animal, amount, type, detail,
+            enclosure < 0 ? EventRecord::NO_ENCLOSURE : static_cast<uint16_t>(enclosure) });
+    }
+    /**
+     * @brief Обновляет пул животных.
+     * @param day Текущий день
+     * @return false, если после 10 дня не хватило денег на обновление.
+     */
+    bool refreshAnimalMarket(int day) {
+        if (day > 10 && animalMarket.size() >= 1) {
+            ZOO_LOG(LogLevel::INFO, "После 10 дня можно обновить рынок только за плату!\n");
+            int refreshCost = 150; // Стоимость обновления рынка
+            if (money < refreshCost) {
+                ZOO_LOG(LogLevel::INFO, "Недостаточно средств для обновления рынка!\n");
+                return false;
+            }
+            money -= refreshCost;
+        }
+        generateAnimalMarket();
+        journal.record("market");
+        ZOO_LOG(LogLevel::INFO, "Рынок животных обновлен!\n");
+        return true;
+    }
+    /**
+ * @brief Переходит к следующему дню в зоопарке.
+ * @details Обрабатывает заражение животных, распространение вируса,
+ * уменьшение популярности и расчет дохода, а также случайные события.
+ */
+    void nextDay() {
+        ZOO_TRACE_SCOPE("nextDay", "day", day);
+        ZOO_LOG(LogLevel::INFO, "\n--- День " << day << " ---\n");
+
+        // Бюджет до дня
+        ZOO_LOG(LogLevel::INFO, "Бюджет прошлого дня: " << money << " монет\n");
+
+        resetDailyCounters();
+
+        {
+            ZOO_PROFILE_PHASE(PHASE_EVENTS);
+            processRandomEvents();
+        }
+
+        // Запланированные смерти от старости, затем старение, заражение и распространение вируса
+        int scheduledDeaths = 0;
+        if (agingMode == AgingMode::CALENDAR) {
+            ZOO_PROFILE_PHASE(PHASE_AGING);
+            scheduledDeaths = processScheduledDeaths();
+        }
+        DayTally tally = tickMode == TickMode::FUSED ? tickFused() : tickMultiPass();
+        tally.oldAgeDeaths += scheduledDeaths;
+        deaths.oldAge += tally.oldAgeDeaths;
+        deaths.virus += tally.virusDeaths;
+        ZOO_COUNT(COUNTER_DAYS, 1);
+        ZOO_COUNT(COUNTER_DEATHS_OLD_AGE, tally.oldAgeDeaths);
+        ZOO_COUNT(COUNTER_DEATHS_VIRUS, tally.virusDeaths);
+
+        int totalAnimals = tally.animals;
+        DayMetrics metric = {}; // Показатели дня; записываются, только если подключён MetricsRecorder
+        {
+            ZOO_PROFILE_PHASE(PHASE_INCOME);
+
+            // Уменьшение популярности из-за больных животных
+            popularity -= tally.infected;
+            popularity = max(popularity, 0);
+
+            // Рассчет посетителей и дохода
+            int visitors = 2 * popularity;
+            int income = visitors * totalAnimals;
+            ZOO_LOG(LogLevel::INFO, "Посетители сегодня: " << visitors << "\n");
+            ZOO_LOG(LogLevel::INFO, "Доход за день: +" << income << " монет\n");
+
+            // Добавляем доход к бюджету
+            money += income;
+            metric[METRIC_VISITORS] = visitors;
+            metric[METRIC_INCOME] = income;
+        }
+
+        // Зарплаты сотрудникам
+        {
+            ZOO_PROFILE_PHASE(PHASE_PAYROLL);
+            money -= payroll; // Вычитаем зарплату из всех денег
+            logEvent(EventType::PAYROLL, NO_ANIMAL, -1, -payroll);
+            for (auto& emp : employees) {
+                emp.currentAnimals = 0; // Сброс счетчика
+            }
+        }
+
+        // Распределение животных между сотрудниками
+        {
+            ZOO_PROFILE_PHASE(PHASE_STAFFING);
+            for (auto& enc : enclosures) { // Перебираем вольеры
+                for (auto& emp : employees) { // Перебираем сотрудников
+                    if (emp.currentAnimals < emp.maxAnimals) {
+                        int canTake = emp.maxAnimals - emp.currentAnimals;
+                        int animalsInEnclosure = enc.animals.size(); // Определяем количество животных в вольере
+                        int assignCount = min(canTake, animalsInEnclosure);
+                        emp.currentAnimals += assignCount; // Обновляем счётчик
+                        if (emp.currentAnimals >= emp.maxAnimals) break;
+                    }
+                }
+            }
+        }
+
+        // Расходы на вольеры
+        {
+            ZOO_PROFILE_PHASE(PHASE_ENCLOSURES);
+            for (auto& enc : enclosures) {
+                money -= enc.dailyCost;
+                metric[METRIC_ENCLOSURE_COST] += enc.dailyCost;
+            }
+        }
+
+        // Питание животных
+        int requiredFood = totalAnimals; // Количество еды, необходимое для всех животных
+        vector<string> deadAnimals; // Имена умерших; собираются, только если уведомления кто-то увидит
+        int starved = 0;
+        if (food >= requiredFood) {
+            ZOO_PROFILE_PHASE(PHASE_FEEDING);
+            food -= requiredFood;
+            money -= requiredFood * 2; // Каждый кг еды стоит 2 монеты
+            metric[METRIC_FEED_COST] = requiredFood * 2;
+        }
+        else {
+            ZOO_PROFILE_PHASE(PHASE_FEEDING);
+            int deficit = requiredFood - food; // Считаем сколько животных останутся голодными
+            bool notify = simSink().enabled(LogLevel::NOTICE);
+            for (auto& enc : enclosures) { // Перебираем животных и со случайным шансом они умирают
+                AnimalStore& animals = enc.animals;
+                size_t i = 0;
+                for (; i < animals.size() && deficit > 0; ++i) {
+                    if (feedingRng.below(2) == 0) {
+                        if (notify) deadAnimals.push_back(animals.name(i)); // Сохраняем имя умершего животного
+                        starved++;
+                        logEvent(EventType::DEATH, animals.ids[i], enc.index, 0, static_cast<uint8_t>(DeathCause::STARVATION));
+                        animals.markDead(i);
+                        deficit--;
+                    }
+                }
+                ZOO_COUNT(COUNTER_SCANNED, i);
+                animals.removeDead(registry);
+            }
+            food = 0;
+            deaths.starvation += starved;
+            ZOO_COUNT(COUNTER_DEATHS_STARVATION, starved);
+        }
+
+        // Колебания популярности
+        {
+            ZOO_PROFILE_PHASE(PHASE_INCOME);
+            int fluctuation = popularity * 0.1;
+            int change = static_cast<int>(popularityRng.below(2 * fluctuation + 1)) - fluctuation;
+            popularity += change;
+            popularity = max(popularity, 0);
+        }
+
+        // Бюджет после дня
+        ZOO_LOG(LogLevel::INFO, "Бюджет текущего дня: " << money << " монет\n");
+
+        // Уведомления о смерти животных
+        if (!deadAnimals.empty()) {
+            ZOO_LOG(LogLevel::NOTICE, "\n--- Уведомления ---\n");
+            for (const string& name : deadAnimals) {
+                ZOO_LOG(LogLevel::NOTICE, "Животное \"" << name << "\" умерло от голода.\n");
+            }
+        }
+
+        // Банкротство (money < 0) проверяет вызывающая сторона: меню или пакетный режим
+
+        if (metrics) {
+            metric[METRIC_DAY] = day;
+            metric[METRIC_MONEY] = money;
+            metric[METRIC_FOOD] = food;
+            metric[METRIC_POPULARITY] = popularity;
+            metric[METRIC_PAYROLL] = payroll;
+            metric[METRIC_DEATHS_OLD_AGE] = tally.oldAgeDeaths;
+            metric[METRIC_DEATHS_VIRUS] = tally.virusDeaths;
+            metric[METRIC_DEATHS_STARVATION] = starved;
+            metric[METRIC_INFECTIONS] = infectionsToday;
+            metric[METRIC_INFECTED] = animalCounts.infected;
+            metric[METRIC_ANIMALS] = animalCounts.animals;
+            metrics->record(metric);
+        }
+
+        // Увеличение дня
+        day++; // Переход к следующему дню
+
+        // Хеш состояния, с которым сверяется воспроизведение журнала
+        if (journal.isOpen()) journal.record("day", stateHash());
+    }
+
+    /**
+     * @brief Дневной проход по животным: по одному обходу на вольер.
+     * @return Итоги по всему зоопарку.
+     */
+    DayTally tickFused() {
+        DayTally tally;
+        for (auto& enc : enclosures) {
+            tally += enc.tick(spreadMode, agingMode);
+        }
+        return tally;
+    }
+    /**
+     * @brief Дневной проход по животным отдельными шагами, как до появления Enclosure::tick.
+     * @details Каждый вольер использует свои потоки случайных чисел, поэтому итог совпадает
+     * с tickFused(); отличается только порядок сообщений.
+     * @return Итоги по всему зоопарку.
+     */
+    DayTally tickMultiPass() {
+        DayTally tally;
+
+        // Ежедневные броски смерти от старости; возраст к концу дня выводится из дня рождения
+        for (auto& enc : enclosures) {
+            if (agingMode != AgingMode::DAILY_ROLL) break;
+            ZOO_PROFILE_PHASE(PHASE_AGING);
+            AnimalStore& animals = enc.animals;
+            ZOO_COUNT(COUNTER_SCANNED, animals.size());
+            for (size_t i = 0; i < animals.size(); ++i) {
+                if (Animal::diesOfOldAge(animals.age(i, day + 1), enc.agingRng)) {
+                    logEvent(EventType::DEATH, animals.ids[i], enc.index, 0, static_cast<uint8_t>(DeathCause::OLD_AGE));
+                    ZOO_LOG(LogLevel::NOTICE, "Животное \"" << animals.name(i) << "\" умерло от старости.\n");
+                    animals.markDead(i);
+                    tally.oldAgeDeaths++;
+                }
+            }
+            animals.removeDead(registry); // Удаляем умерших одним проходом
+        }
+
+        // Заражение случайного животного
+        for (auto& enc : enclosures) {
+            ZOO_PROFILE_PHASE(PHASE_INFECTION);
+            enc.infectRandomAnimal();
+        }
+
+        // Распространение вируса
+        for (auto& enc : enclosures) {
+            ZOO_PROFILE_PHASE(PHASE_SPREAD);
+            tally.virusDeaths += enc.spreadVirus(spreadMode);
+        }
+
+        // Подсчёт больных и всех животных обходом, без счётчиков
+        for (auto& enc : enclosures) {
+            for (uint8_t f : enc.animals.flags) {
+                if (f & AnimalStore::INFECTED) tally.infected++;
+            }
+            tally.animals += static_cast<int>(enc.animals.size());
+        }
+        return tally;
+    }
+
+    /**
+     * @brief Разыгрывает случайное событие дня (см. RANDOM_EVENTS).
+     */
+    void processRandomEvents() {
+        const int EVENT_PROBABILITY = 20; // 20% вероятность события
+
+        // Генерация случайных событий
+        if (eventsRng.chance(EVENT_PROBABILITY)) {
+            bool isPositive = eventsRng.below(2) == 0; // 50% шанс на положительное или отрицательное событие
+            int eventIndex = (isPositive ? 0 : RANDOM_EVENTS_PER_KIND) + eventsRng.below(RANDOM_EVENTS_PER_KIND);
+            const RandomEvent& event = RANDOM_EVENTS[eventIndex];
+            ZOO_LOG(LogLevel::NOTICE, "Событие: " << event.title << "\n");
+            popularity += event.popularity; // Выполняем эффект события
+            money += event.money;
+            ZOO_LOG(LogLevel::NOTICE, event.message << "\n");
+            logEvent(EventType::RANDOM_EVENT, NO_ANIMAL, -1, event.money, static_cast<uint8_t>(eventIndex));
+        }
+    }
+    /**
+     * @brief Лечит животное, спросив подтверждение у игрока.
+     * @param id Дескриптор животного для лечения
+     */
+    void cureAnimal(AnimalId id) {
+        size_t index;
+        Enclosure* enc = findAnimal(id, index); // Находим животное по дескриптору
+        if (!enc) { // Если животное не найдено
+            cout << "Животное не найдено.\n";
+            return;
+        }
+
+        const string& name = enc->animals.name(index);
+        if (!enc->animals.isInfected(index)) { // Проверяем, заражено ли оно
+            cout << "Животное \"" << name << "\" не заражено.\n";
+            return;
+        }
+
+        // Запрос подтверждения на лечение
+        cout << "Лечение животного \"" << name << "\" стоит " << CURE_COST << " монет.\n";
+        cout << "Хотите продолжить?\n";
+        cout << "1. Да\n2. Нет\n";
+        int confirm = getIntegerInput("Ваш выбор: ");
+        if (confirm != 1) { // Если пользователь отказался
+            cout << "Лечение отменено.\n";
+            return;
+        }
+
+        // Проверка наличия средств
+        if (!canAfford(CURE_COST)) {
+            cout << "Недостаточно средств для лечения!\n";
+            return;
+        }
+
+        treatAnimal(id);
+    }
+
+    // Действия игрока. Меню спрашивает ввод, а правила игры (цены, деньги, допустимые значения),
+    // изменение состояния и запись в журнал действий — в этих методах; воспроизведение журнала
+    // и сервер сеансов вызывают их же. Нарушившее правила действие ничего не меняет.
+
+    static const int CURE_COST = 30;           ///< Стоимость лечения
+    static const int FOOD_PRICE = 2;           ///< Цена 1 кг еды
+    static const int COST_PER_POPULARITY = 20; ///< Стоимость одной единицы популярности в рекламе
+    static const int MAX_ENCLOSURE_CAPACITY = 100000; ///< Наибольшая вместимость строящегося вольера
+
+    /**
+     * @brief Хватает ли денег на трату.
+     * @param cost Сумма; отрицательная сумма не считается тратой
+     */
+    bool canAfford(int64_t cost) const {
+        return cost >= 0 && money >= cost;
+    }
+    /**
+     * @brief Допустимы ли климат и вместимость нового вольера.
+     * @param climate Номер климата (Animal::Climate)
+     * @param capacity Вместимость: от 1 до MAX_ENCLOSURE_CAPACITY
+     */
+    static bool validEnclosure(int climate, int capacity) {
+        return climate >= Animal::DESERT && climate <= Animal::OCEAN && capacity >= 1 && capacity <= MAX_ENCLOSURE_CAPACITY;
+    }
+
+    /**
+     * @brief Начинает журнал действий: заголовок и строка с начальным состоянием.
+     * @param path Путь к файлу журнала
+     * @throws runtime_error Если файл не создаётся.
+     */
+    void startJournal(const string& path) {
+        journal.open(path);
+        journal.record("zoo", seed, money, name);
+    }
+    /**
+     * @brief Лечит заражённое животное.
+     * @param id Дескриптор животного
+     * @return false, если животного нет, оно здорово или не хватает денег.
+     */
+    bool treatAnimal(AnimalId id) {
+        size_t index;
+        Enclosure* enc = findAnimal(id, index);
+        if (!enc || !enc->animals.isInfected(index) || !canAfford(CURE_COST)) return false;
+        enc->animals.setInfected(index, false); // Лечим животное
+        money -= CURE_COST; // Вычитаем стоимость лечения из бюджета
+        journal.record("cure", id);
+        ZOO_LOG(LogLevel::INFO, "Животное \"" << enc->animals.name(index) << "\" успешно вылечено!\n");
+        return true;
+    }
+    /**
+     * @brief Строит вольер за его стоимость (Enclosure::calculateCost).
+     * @param climate Номер климата (Animal::Climate)
+     * @param capacity Вместимость (см. validEnclosure)
+     * @return Построенный вольер или nullptr, если климат или вместимость недопустимы или не хватает денег.
+     */
+    Enclosure* buildEnclosure(int climate, int capacity) {
+        if (!validEnclosure(climate, capacity)) return nullptr;
+        Animal::Climate enclosureClimate = static_cast<Animal::Climate>(climate);
+        int cost = Enclosure(enclosureClimate, capacity).calculateCost();
+        if (!canAfford(cost)) return nullptr;
+        Enclosure& enc = addEnclosure(enclosureClimate, capacity);
+        money -= cost;
+        journal.record("build", climate, capacity);
+        return &enc;
+    }
+    /**
+     * @brief Улучшает вольер за Enclosure::upgradeCost.
+     * @param enclosure Номер вольера
+     * @return false, если вольера нет, уровень уже наибольший или не хватает денег.
+     */
+    bool upgradeEnclosure(size_t enclosure) {
+        if (enclosure >= enclosures.size()) return false;
+        Enclosure& enc = enclosures[enclosure];
+        int cost = enc.upgradeCost();
+        if (!canAfford(cost) || !enc.upgrade(cost)) return false;
+        money -= cost;
+        journal.record("upgrade", enclosure);
+        return true;
+    }
+    /**
+     * @brief Покупает животное с рынка и селит его в вольер.
+     * @param marketIndex Номер животного на рынке
+     * @param enclosure Номер вольера
+     * @param animalName Имя животного
+     * @return Дескриптор купленного животного или NO_ANIMAL, если купить не удалось.
+     */
+    AnimalId buyAnimal(size_t marketIndex, size_t enclosure, const string& animalName) {
+        if (marketIndex >= animalMarket.size() || enclosure >= enclosures.size()) return NO_ANIMAL;
+        Animal animal = animalMarket[marketIndex];
+        animal.name = animalName;
+        int price = animal.calculatePrice();
+        if (!canAfford(price)) return NO_ANIMAL;
+        AnimalId id = enclosures[enclosure].addAnimal(animal);
+        if (id == NO_ANIMAL) return NO_ANIMAL;
+        money -= price;
+        logEvent(EventType::PURCHASE, id, static_cast<int>(enclosure), -price);
+        animalMarket.erase(animalMarket.begin() + marketIndex); // Купленное животное уходит с рынка
+        journal.record("buy", marketIndex, enclosure, animalName);
+        return id;
+    }
+    /**
+     * @brief Продаёт животное за Animal::calculateSalePrice.
+     * @param enclosure Номер вольера
+     * @param row Строка животного в вольере
+     * @return Вырученные деньги или -1, если такого животного нет.
+     */
+    int sellAnimal(size_t enclosure, size_t row) {
+        if (enclosure >= enclosures.size() || row >= enclosures[enclosure].animals.size()) return -1;
+        Enclosure& enc = enclosures[enclosure];
+        Animal animal = enc.animals.get(row, day);
+        int sellPrice = animal.calculateSalePrice();
+        money += sellPrice;
+        logEvent(EventType::SALE, animal.id, enc.index, sellPrice);
+        enc.removeAnimal(animal.id);
+        journal.record("sell", enclosure, row);
+        return sellPrice;
+    }
+    /**
+     * @brief Нанимает сотрудника на должность из EMPLOYEE_POSITIONS, оплачивая первую зарплату.
+     * @param position Номер должности (с 0)
+     * @param employeeName Имя
+     * @return Новый сотрудник или nullptr, если должности нет или не хватает денег на зарплату.
+     */
+    Employee* hireStaff(int position, const string& employeeName) {
+        if (position < 0 || position >= EMPLOYEE_POSITION_COUNT) return nullptr;
+        const EmployeePosition& pos = EMPLOYEE_POSITIONS[position];
+        if (!canAfford(pos.salary)) return nullptr;
+        Employee& employee = hireEmployee(employeeName, pos.title, pos.salary, pos.maxAnimals);
+        money -= pos.salary;
+        journal.record("hire", position, employeeName);
+        return &employee;
+    }
+    /**
+     * @brief Увольняет сотрудника.
+     * @param position Номер сотрудника в списке employees (с 0)
+     * @return false, если такого сотрудника нет.
+     */
+    bool dismissEmployee(size_t position) {
+        if (position >= employees.size()) return false;
+        fireEmployee(next(employees.begin(), position));
+        journal.record("fire", position);
+        return true;
+    }
+    /**
+     * @brief Покупает еду по FOOD_PRICE за кг.
+     * @param amount Килограммы, больше нуля
+     * @return false, если количество недопустимо или не хватает денег.
+     */
+    bool buyFood(int amount) {
+        if (amount <= 0 || amount > numeric_limits<int>::max() - food) return false;
+        int64_t cost = static_cast<int64_t>(amount) * FOOD_PRICE;
+        if (!canAfford(cost)) return false;
+        food += amount;
+        money -= static_cast<int>(cost);
+        journal.record("food", amount);
+        return true;
+    }
+    /**
+     * @brief Заказывает рекламу: единица популярности за COST_PER_POPULARITY монет.
+     * @param cost Сумма рекламной кампании, больше нуля
+     * @return Прирост популярности или -1, если сумма недопустима или не хватает денег.
+     */
+    int advertise(int cost) {
+        if (cost <= 0 || !canAfford(cost)) return -1;
+        int popularityIncrease = cost / COST_PER_POPULARITY; // Рассчитываем прирост популярности
+        money -= cost;
+        popularity += popularityIncrease;
+        journal.record("advertise", cost);
+        return popularityIncrease;
+    }
+    /**
+     * @brief Переименовывает животное.
+     * @param id Дескриптор животного
+     * @param newName Новое имя
+     * @return false, если животного больше нет в зоопарке.
+     */
+    bool setAnimalName(AnimalId id, const string& newName) {
+        size_t row;
+        Enclosure* enc = findAnimal(id, row);
+        if (!enc) return false;
+        enc->animals.setName(row, newName);
+        journal.record("rename", id, newName);
+        return true;
+    }
+
+    /**
+     * @brief Средний расход памяти на одно животное.
+     * @return Байт на животное: хранилища всех вольеров плюс реестр дескрипторов.
+     */
+    double bytesPerAnimal() const {
+        size_t bytes = registry.memoryUsage();
+        size_t count = 0;
+        for (const auto& enc : enclosures) {
+            bytes += enc.animals.memoryUsage();
+            count += enc.animals.size();
+        }
+        return count == 0 ? 0.0 : static_cast<double>(bytes) / count;
+    }
+
+    /**
+     * @brief Хеш состояния зоопарка для сверки двух прогонов.
+     * @details Учитывает деньги, ресурсы, день, генераторы, вольеры со всеми животными
+     * и сотрудников; сообщения дня и рынок не учитываются.
+     */
+    uint64_t stateHash() const {
+        StateHash h;
+        h.add(money); h.add(food); h.add(popularity); h.add(day);
+        h.add(deaths.oldAge); h.add(deaths.virus); h.add(deaths.starvation);
+        for (const Rng* rng : { &eventsRng, &marketRng, &feedingRng, &popularityRng, &breedingRng }) {
+            h.add(rng->key); h.add(rng->counter);
+        }
+        h.add(registry.size());
+        for (const auto& enc : enclosures) {
+            h.add(enc.climate); h.add(enc.capacity); h.add(enc.level); h.add(enc.dailyCost);
+            for (const Rng* rng : { &enc.agingRng, &enc.infectionRng, &enc.spreadRng }) {
+                h.add(rng->key); h.add(rng->counter);
+            }
+            const AnimalStore& animals = enc.animals;
+            h.add(animals.weights.values()); h.add(animals.flags.values());
+            h.add(animals.species.values()); h.add(animals.birthDays.values()); h.add(animals.ids.values());
+            h.add(animals.parents.values()); h.add(animals.deathDays.values());
+            for (size_t i = 0; i < animals.size(); ++i) {
+                h.add(animals.name(i));
+            }
+        }
+        for (const auto& emp : employees) {
+            h.add(emp.name); h.add(emp.position); h.add(emp.salary);
+            h.add(emp.maxAnimals); h.add(emp.currentAnimals);
+        }
+        return h.value;
+    }
+
+    /**
+     * @brief Проверяет, обанкротился ли зоопарк.
+     */
+    bool isBankrupt() const {
+        return money < 0;
+    }
+
+    /**
+     * @brief Подсчитывает общее количество животных в зоопарке.
+     * @return Общее количество животных.
+     */
+    int getTotalAnimals() const {
+        return animalCounts.animals;
+    }
+};
+
+AnimalRegistry& Enclosure::registry() {
+    return zoo->registry;
+}
+
+Rng& Enclosure::breedingRng() {
+    return zoo->breedingRng;
+}
+
+int Enclosure::today() const {
+    return zoo->day;
+}
+
+void Enclosure::scheduleDeath(size_t row) {
+    if (zoo->agingMode != AgingMode::CALENDAR) return;
+    int age = animals.age(row, zoo->day);
+    int deathAge = Animal::sampleDeathAge(age, agingRng);
+    // В nextDay дня d возраст становится age + (d - day) + 1
+    uint32_t deathDay = static_cast<uint32_t>(zoo->day + (deathAge - age) - 1);
+    animals.setDeathDay(row, deathDay);
+    zoo->deathCalendar.schedule(animals.ids[row], deathDay);
+}
+
+void Enclosure::logEvent(EventType type, AnimalId animal, int amount, uint8_t detail) {
+    zoo->logEvent(type, animal, index, amount, detail);
+}
+
+vector<string> Enclosure::breedPair(size_t parent1, size_t parent2, const function<string(SpeciesId)>& nameOffspring) {
+    if (!canBreed(parent1, parent2)) return {};
+    int day = today();
+    // Копии родителей: добавление потомков может перераспределить столбцы
+    const Animal mother = animals.get(parent1, day);
+    const Animal father = animals.get(parent2, day);
+
+    // Генерация потомков
+    Rng& rng = breedingRng();
+    int offspringCount = rng.chance(10) ? 2 : 1; // 10% шанс на двух потомков
+    offspringCount = min(offspringCount, capacity - static_cast<int>(animals.size())); // Учитываем вместимость вольера
+
+    if (offspringCount == 0) {
+        ZOO_LOG(LogLevel::INFO, "Вольер переполнен! Размножение невозможно.\n");
+        zoo->journal.record("breed", index, parent1, parent2, 0); // Бросок генератора уже сделан
+        return {};
+    }
+
+    vector<string> born;
+    for (int i = 0; i < offspringCount; ++i) {
+        try {
+            // Создаем новый вид как комбинацию видов родителей
+            SpeciesId newSpecies = combineSpecies(mother.species, father.species, rng);
+
+            string newName = nameOffspring(newSpecies);
+
+            Animal::Type newType = mother.isAquatic() || father.isAquatic() ? Animal::AQUATIC : Animal::LAND;
+
+            // Создаем новое животное
+            char newGender = rng.below(2) == 0 ? 'M' : 'F';
+            Animal offspring(
+                newName,                  // Имя
+                newSpecies,               // Новый вид
+                1,                        // Возраст (1 день)
+                (mother.weight + father.weight) / 2, // Средний вес
+                mother.climate(),         // Климат
+                mother.isCarnivore() || father.isCarnivore(), // Тип питания
+                newGender,               // Пол
+                newType,
+                mother.id,                // Первый родитель
+                father.id                 // Второй родитель
+            );
+
+            // Добавляем потомка в вольер
+            logEvent(EventType::BIRTH, insertAnimal(offspring));
+            born.push_back(offspring.name);
+            ZOO_LOG(LogLevel::INFO, "Рождено новое животное: " << offspring.name
+                << " (" << (offspring.gender() == 'M' ? "М" : "Ж") << "), Вид: " << offspring.speciesName() << "\n");
+        }
+        catch (const runtime_error& e) {
+            ZOO_LOG(LogLevel::INFO, e.what() << "\n");
+        }
+    }
+    zoo->journal.record("breed", index, parent1, parent2, born.size());
+    for (const string& name : born) zoo->journal.record("name", name);
+    return born;
+}
+
+/**
+ * @brief Печатает запись журнала событий текстом.
+ * @param out Поток вывода
+ * @param event Запись журнала
+ * @param zoo Зоопарк, в котором ищутся имена животных, или nullptr
+ */
+void printEvent(ostream& out, const EventRecord& event, const Zoo* zoo) {
+    static const char* const CAUSES[] = { "от старости", "от терановируса", "от голода" };
+    // Выбывшие и безымянные животные показываются по номеру дескриптора
+    string animal = zoo ? zoo->animalName(event.animal) : "";
+    animal = animal.empty() ? "#" + to_string(event.animal & AnimalRegistry::INDEX_MASK) : "\"" + animal + "\"";
+    out << "День " << event.day << ": ";
+    switch (event.type) {
+    case EventType::INFECTION: out << "животное " << animal << " заразилось терановирусом"; break;
+    case EventType::DEATH: out << "животное " << animal << " умерло " << (event.detail < 3 ? CAUSES[event.detail] : "?"); break;
+    case EventType::BIRTH: out << "родилось животное " << animal; break;
+    case EventType::PURCHASE: out << "куплено животное " << animal << " за " << -event.amount << " монет"; break;
+    case EventType::SALE: out << "продано животное " << animal << " за " << event.amount << " монет"; break;
+    case EventType::RANDOM_EVENT:
+        out << (event.detail < 2 * RANDOM_EVENTS_PER_KIND ? RANDOM_EVENTS[event.detail].message : "неизвестное событие");
+        break;
+    case EventType::PAYROLL: out << "выплачены зарплаты: " << -event.amount << " монет"; break;
+    default: out << "неизвестная запись"; break;
+    }
+    if (event.enclosure != EventRecord::NO_ENCLOSURE) out << " (вольер " << event.enclosure + 1 << ")";
+    out << "\n";
+}
+
+void Animal::printParents(const Zoo& zoo) const {
+    if (parents.first == NO_ANIMAL && parents.second == NO_ANIMAL) {
+        cout << "Родители неизвестны";
+        return;
+    }
+    // Выбывшие из зоопарка родители показываются по номеру дескриптора
+    auto describe = [&zoo](AnimalId id) {
+        return zoo.registry.contains(id) ? zoo.animalName(id) : "#" + to_string(id & AnimalRegistry::INDEX_MASK) + " (выбыл)";
+    };
+    cout << "Родители: " << describe(parents.first) << " и " << describe(parents.second);
+}
+/**
+ * @brief Получает целочисленный ввод от пользователя.
+ * @details Как и прежде с cin: пустые строки пропускаются, число берётся из начала строки,
+ * остаток строки отбрасывается.
+ * @param prompt Сообщение пользователю перед запросом ввода.
+ * @return Введенное пользователем число.
+ * @throws InputExhausted Если ввод закончился.
+ */
+int getIntegerInput(const string& prompt) {
+    cout << prompt;
+    string line;
+    while (true) {
+        if (!input().readLine(line)) throw InputExhausted();
+        const char* begin = line.c_str();
+        while (isspace(static_cast<unsigned char>(*begin))) begin++;
+        if (*begin == '\0') continue; // Пустая строка: ждём дальше, не повторяя приглашение
+
+        char* end;
+        errno = 0;
+        long value = strtol(begin, &end, 10);
+        if (end != begin && errno != ERANGE && value >= numeric_limits<int>::min() && value <= numeric_limits<int>::max()) {
+            return static_cast<int>(value);
+        }
+        cout << "Некорректный ввод. Попробуйте снова.\n";
+        cout << prompt;
+    }
+}
+
+/**
+ * @brief Считывает строку ввода целиком.
+ * @return Строка без символа перевода строки.
+ * @throws InputExhausted Если ввод закончился.
+ */
+string getLineInput() {
+    string line;
+    if (!input().readLine(line)) throw InputExhausted();
+    return line;
+}
+
+/**
+ * @brief Управляет сотрудниками зоопарка.
+ * @param zoo Ссылка на объект зоопарка
+ */
+void manageEmployees(Zoo& zoo) {
+    cout << "\n--- Управление работниками ---\n";
+    cout << "1. Нанять сотрудника\n";
+    cout << "2. Уволить сотрудника\n";
+    cout << "3. Просмотреть список\n";
+    cout << "0. Назад\n";
+
+    int choice = getIntegerInput("Выберите действие: ");
+    switch (choice) {
+    case 1: {
+        cout << "\nНаем сотрудника:\n";
+        string name;
+        cout << "Введите имя: ";
+        name = getLineInput();
+
+        for (int i = 0; i < EMPLOYEE_POSITION_COUNT; ++i) {
+            cout << i + 1 << ". " << EMPLOYEE_POSITIONS[i].title << "\n";
+        }
+        int posChoice = getIntegerInput("Выберите должность: ");
+        if (posChoice < 1 || posChoice > EMPLOYEE_POSITION_COUNT) {
+            cout << "Неверный выбор!\n";
+            return;
+        }
+        if (zoo.hireStaff(posChoice - 1, name)) {
+            cout << "Сотрудник нанят!\n";
+        }
+        else {
+            cout << "Недостаточно средств!\n";
+        }
+        break;
+    }
+    case 2: {
+        cout << "\nУвольнение сотрудника:\n";
+        int index = 1;
+        for (auto& emp : zoo.employees) {
+            if (emp.position != "Директор") { // Исключаем директора
                 cout << index << ". " << emp.name << " (" << emp.position << ")\n";
                 index++;
             }
         }
-        int choice = getIntegerInput("Введите номер сотрудника: ");
-        if (choice <= 0 || choice >= index) {
-            cout << "Неверный номер!\n";
+        int choice = getIntegerInput("Введите номер сотрудника: ");
+        if (choice <= 0 || choice >= index) {
+            cout << "Неверный номер!\n";
+            break;
+        }
+
+        auto it = zoo.employees.begin();
+        while (it != zoo.employees.end()) {
+            if (it->position == "Директор") {
+                ++it; // Пропускаем директора
+                continue;
+            }
+            if (choice == 1) {
+                zoo.dismissEmployee(distance(zoo.employees.begin(), it));
+                cout << "Сотрудник уволен!\n";
+                break;
+            }
+            --choice;
+            ++it;
+        }
+        break;
+    }
+    case 3: {
+        cout << "\nСписок сотрудников:\n";
+        for (auto& emp : zoo.employees) {
+            cout << "- " << emp.name << " (" << emp.position << ") Зарплата: "
+                << emp.salary << ", Обслуживает: " << emp.currentAnimals << "/"
+                << emp.maxAnimals << " животных\n";
+        }
+        break;
+    }
+    case 0:
+        return;
+    }
+}
+/**
+ * @brief Управляет вольерами зоопарка.
+ * @param zoo Ссылка на объект зоопарка
+ */
+void manageEnclosures(Zoo& zoo) {
+    cout << "\n--- Управление вольерами ---\n";
+    cout << "1. Построить вольер\n";
+    cout << "2. Улучшить вольер\n";
+    cout << "3. Просмотреть вольеры\n";
+    cout << "0. Назад\n";
+
+    int choice = getIntegerInput("Выберите действие: ");
+    switch (choice) {
+    case 1: {
+        cout << "\n--- Создание нового вольера ---\n";
+        cout << "Выберите климат для вольера:\n";
+        cout << "0. Пустыня (Множитель цены: 1.2)\n";
+        cout << "1. Лес (Множитель цены: 1.0)\n";
+        cout << "2. Арктика (Множитель цены: 1.5)\n";
+        cout << "3. Океан (Множитель цены: 1.8)\n";
+        int climate = getIntegerInput("Ваш выбор: ");
+
+        int capacity = getIntegerInput("Вместимость (Одно место = 50 монет): ");
+        if (!Zoo::validEnclosure(climate, capacity)) {
+            cout << "Неверный климат или вместимость (от 1 до " << Zoo::MAX_ENCLOSURE_CAPACITY << ")!\n";
+            break;
+        }
+
+        // Создаем временный вольер для расчета стоимости
+        Enclosure newEnclosure(static_cast<Animal::Climate>(climate), capacity);
+        int cost = newEnclosure.calculateCost();
+
+        cout << "Стоимость вольера: " << cost << " монет\n";
+        cout << "Хотите построить этот вольер?\n";
+        cout << "1. Да\n2. Нет\n";
+        int confirm = getIntegerInput("Ваш выбор: ");
+
+        if (confirm != 1) {
+            cout << "Строительство отменено.\n";
+            break;
+        }
+
+        if (!zoo.buildEnclosure(climate, capacity)) {
+            cout << "Недостаточно средств для строительства!\n";
+            break;
+        }
+        cout << "Вольер успешно построен!\n";
+        break;
+    }
+    case 2: {
+        cout << "\nУлучшение вольера:\n";
+        int index = 1;
+        for (auto& enc : zoo.enclosures) {
+            string climate;
+            switch (enc.climate) {
+            case Animal::DESERT: climate = "Пустыня"; break;
+            case Animal::FOREST: climate = "Лес"; break;
+            case Animal::ARCTIC: climate = "Арктика"; break;
+            case Animal::OCEAN: climate = "Океан"; break;
+            }
+            cout << index << ". Климат: " << climate
+                << ", Уровень: " << enc.level
+                << ", Животных: " << enc.animals.size() << "/" << enc.capacity
+                << ", Расходы в день: " << enc.dailyCost << "\n";
+            index++;
+        }
+
+        int choice = getIntegerInput("Введите номер вольера для улучшения: ");
+        if (choice <= 0 || choice > zoo.enclosures.size()) {
+            cout << "Неверный номер!\n";
+            break;
+        }
+
+        auto it = zoo.enclosures.begin();
+        advance(it, choice - 1); // Перемещаем итератор
+
+        // Рассчитываем стоимость улучшения
+        int upgradeCost = it->upgradeCost();
+        cout << "Стоимость улучшения: " << upgradeCost << " монет\n";
+        int confirm = 3;
+        while (confirm == 3) {
+            cout << "Хотите улучшить этот вольер?\n";
+            cout << "1. Да\n2. Нет\n3. Прогноз на 10 дней с улучшением и без\n";
+            confirm = getIntegerInput("Ваш выбор: ");
+            if (confirm == 3) {
+                size_t enclosure = choice - 1;
+                showForecast(zoo, "С улучшением", [enclosure](Zoo& fork) { fork.upgradeEnclosure(enclosure); });
+            }
+        }
+
+        if (confirm != 1) {
+            cout << "Улучшение отменено.\n";
+            break;
+        }
+
+        if (!zoo.canAfford(upgradeCost)) {
+            cout << "Недостаточно средств для улучшения!\n";
+            break;
+        }
+
+        if (zoo.upgradeEnclosure(choice - 1)) {
+            cout << "Вольер успешно улучшен до уровня " << it->level << "!\n";
+        }
+        break;
+    }
+    case 3: {
+        cout << "\nСписок вольеров:\n";
+        int index = 1;
+        for (auto& enc : zoo.enclosures) {
+            string climate;
+            switch (enc.climate) {
+            case Animal::DESERT: climate = "Пустыня"; break;
+            case Animal::FOREST: climate = "Лес"; break;
+            case Animal::ARCTIC: climate = "Арктика"; break;
+            case Animal::OCEAN: climate = "Океан"; break;
+            }
+            cout << index << ". Климат: " << climate
+                << ", Уровень: " << enc.level
+                << ", Животных: " << enc.animals.size() << "/" << enc.capacity
+                << ", Расходы в день: " << enc.dailyCost << "\n";
+            index++;
+        }
+        break;
+    }
+    case 0:
+        return;
+    }
+}
+
+/**
+ * @brief Получает список видов животных для указанного климата.
+ * @param climate Климат, для которого нужно получить виды.
+ * @return Идентификаторы видов для указанного климата (без копирования).
+ */
+const vector<SpeciesId>& getSpeciesByClimate(Animal::Climate climate) {
+    return SpeciesTable::instance().byClimate(static_cast<int>(climate));
+}
+
+/**
+ * @brief Получает случайный вид животного для указанного климата.
+ * @param climate Климат, для которого нужно получить случайный вид.
+ * @param rng Генератор случайных чисел
+ * @return Идентификатор случайного вида.
+ */
+SpeciesId getRandomSpecies(Animal::Climate climate, Rng& rng) {
+    if (climate < Animal::DESERT || climate > Animal::OCEAN) {
+        return SpeciesTable::instance().unknown();
+    }
+    const vector<SpeciesId>& species = getSpeciesByClimate(climate);
+    return species[rng.below(static_cast<uint32_t>(species.size()))];
+}
+/**
+ * @brief Генерирует случайное животное.
+ * @details Создает животное со случайными характеристиками, включая возраст, вес, климат, тип питания, пол и вид.
+ * @param rng Генератор случайных чисел
+ * @return Новое случайно сгенерированное животное.
+ */
+Animal generateRandomAnimal(Rng& rng) {
+    Animal::Climate climates[] = { Animal::DESERT, Animal::FOREST, Animal::ARCTIC, Animal::OCEAN };
+
+    int randomAge = rng.below(20) + 1;       // Возраст от 1 до 20
+    int randomWeight = rng.below(96) + 5;  // Вес от 5 lj 100
+    Animal::Climate randomClimate = climates[rng.below(4)]; // Случайный климат
+    bool isCarnivore = rng.below(2) == 0;    // Хищник или травоядное
+    char randomGender = rng.below(2) == 0 ? 'M' : 'F'; // Случайный пол
+
+    SpeciesId randomSpecies = getRandomSpecies(randomClimate, rng);
+
+    Animal::Type randomType = (randomClimate == Animal::OCEAN) ? Animal::AQUATIC : Animal::LAND;
+
+    return Animal("", randomSpecies, randomAge, randomWeight, randomClimate, isCarnivore, randomGender, randomType);
+}
+/**
+ * @brief Изменяет имя животного в выбранном вольере.
+ * @details Позволяет пользователю выбрать вольер, затем выбрать животное в этом вольере и изменить его имя.
+ * @param zoo Ссылка на объект зоопарка.
+ */
+void renameAnimal(Zoo& zoo) {
+    if (zoo.enclosures.empty()) {
+        cout << "У вас нет вольеров!\n";
+        return;
+    }
+
+    // Вывод списка вольеров
+    int index = 1;
+    for (auto& enc : zoo.enclosures) {
+        string climateName;
+        switch (enc.climate) {
+        case Animal::DESERT: climateName = "Пустыня"; break;
+        case Animal::FOREST: climateName = "Лес"; break;
+        case Animal::ARCTIC: climateName = "Арктика"; break;
+        case Animal::OCEAN: climateName = "Океан"; break;
+        }
+        cout << index << ". Климат: " << climateName
+            << ", Животных: " << enc.animals.size() << "/" << enc.capacity << "\n";
+        index++;
+    }
+
+    // Выбор вольера
+    int enclosureChoice = getIntegerInput("Введите номер вольера: ");
+    if (enclosureChoice <= 0 || enclosureChoice > zoo.enclosures.size()) {
+        cout << "Неверный номер вольера!\n";
+        return;
+    }
+
+    auto encIt = zoo.enclosures.begin();
+    advance(encIt, enclosureChoice - 1);
+
+    // Проверка, есть ли животные в вольере
+    if (encIt->animals.empty()) {
+        cout << "В этом вольере нет животных!\n";
+        return;
+    }
+
+    // Вывод списка животных в выбранном вольере
+    cout << "Животные в вольере:\n";
+    const AnimalStore& animals = encIt->animals;
+    for (size_t i = 0; i < animals.size(); ++i) {
+        cout << i + 1 << ". " << animals.name(i) << ", Вид: " << animals.speciesName(i)
+            << ", Возраст: " << animals.age(i, zoo.day) << " дней\n";
+    }
+
+    // Выбор животного
+    int animalChoice = getIntegerInput("Введите номер животного для изменения имени: ");
+    if (animalChoice <= 0 || animalChoice > encIt->animals.size()) {
+        cout << "Неверный номер животного!\n";
+        return;
+    }
+
+    AnimalId id = encIt->animals.ids[animalChoice - 1];
+
+    // Запрос нового имени
+    cout << "Текущее имя: " << zoo.animalName(id) << "\n";
+    cout << "Введите новое имя: ";
+    string newName;
+    newName = getLineInput();
+
+    // Изменение имени
+    if (!zoo.setAnimalName(id, newName)) {
+        cout << "Животное больше не в зоопарке!\n";
+        return;
+    }
+    cout << "Имя успешно изменено на \"" << newName << "\".\n";
+}
+
+/**
+ * @brief Управляет животными зоопарка.
+ * @param zoo Ссылка на объект зоопарка
+ */
+void manageAnimals(Zoo& zoo) {
+    cout << "\n--- Управление животными ---\n";
+    cout << "1. Купить готовое животное\n";
+    cout << "2. Продать животное\n";
+    cout << "3. Просмотреть животных\n";
+    cout << "4. Лечение жвиотных\n";
+    cout << "5. Обновить список животных (цена 150 монет)\n";
+    cout << "6. Размножить животных\n";
+    cout << "7. Изменить имя животного\n";
+    cout << "0. Назад\n";
+
+    int choice = getIntegerInput("Выберите действие: ");
+    switch (choice) {
+    case 1: { // Покупка готового животного
+        cout << "\n--- Покупка готового животного ---\n";
+
+        if (zoo.animalMarket.empty()) {
+            cout << "На рынке нет доступных животных!\n";
+            break;
+        }
+
+        // Ограничение на покупку после 10 - го дня
+        if (zoo.day > 10) {
+            cout << "После 10-го дня можно купить только одно животное в день!\n";
+            if (zoo.animalsBoughtToday >= 1) {
+                cout << "Вы уже купили животное сегодня.\n";
+                break;
+            }
+        }
+
+        // Выводим список животных
+        cout << "Доступные животные:\n";
+        for (int i = 0; i < zoo.animalMarket.size(); ++i) {
+            Animal& animal = zoo.animalMarket[i];
+            string climateName;
+            switch (animal.climate()) {
+            case Animal::DESERT: climateName = "Пустыня"; break;
+            case Animal::FOREST: climateName = "Лес"; break;
+            case Animal::ARCTIC: climateName = "Арктика"; break;
+            case Animal::OCEAN: climateName = "Океан"; break;
+            }
+            cout << i + 1 << ". Вид: " << animal.speciesName() // Название из таблицы видов
+                << ", Климат: " << climateName
+                << ", Возраст: " << animal.ageInDays << " дней"
+                << ", Вес: " << animal.weight << " кг"
+                << ", Пол: " << (animal.gender() == 'M' ? "М" : "Ж")
+                << ", Тип: " << (animal.isCarnivore() ? "Хищник" : "Травоядное")
+                << ", Тип животного: " << (animal.isAquatic() ? "Вода" : "Земля")
+                << ", Цена: " << animal.calculatePrice() << "\n";
+        }
+        // Выбор животного
+        int choice = getIntegerInput("Введите номер животного для покупки: ");
+        if (choice <= 0 || choice > zoo.animalMarket.size()) {
+            cout << "Неверный номер!\n";
+            break;
+        }
+
+        Animal selectedAnimal = zoo.animalMarket[choice - 1];
+        int price = selectedAnimal.calculatePrice();
+
+        cout << "Итоговая цена животного: " << price << " монет\n";
+        cout << "Хотите купить это животное?\n";
+        cout << "1. Да\n2. Нет\n";
+        int confirm = getIntegerInput("Ваш выбор: ");
+
+        if (confirm != 1) {
+            cout << "Покупка отменена.\n";
+            break;
+        }
+
+        if (!zoo.canAfford(price)) {
+            cout << "Недостаточно средств для покупки!\n";
+            break;
+        }
+
+        // Запрос имени для животного
+        string name;
+        cout << "Введите имя для животного: ";
+        name = getLineInput();
+        selectedAnimal.name = name;
+
+        // Фильтрация вольеров по климату
+        vector<Enclosure*> suitableEnclosures;
+        for (auto& enc : zoo.enclosures) {
+            if (enc.climate == selectedAnimal.climate() && enc.canAddAnimal(selectedAnimal)) {
+                suitableEnclosures.push_back(&enc);
+            }
+        }
+
+        if (suitableEnclosures.empty()) {
+            cout << "Ошибка: Нет подходящего вольера!\n";
+            break;
+        }
+
+        // Вывод подходящих вольеров
+        cout << "\nВыберите вольер для размещения животного:\n";
+        for (int i = 0; i < suitableEnclosures.size(); ++i) {
+            Enclosure* enc = suitableEnclosures[i];
+            cout << i + 1 << ". Климат: " << (enc->climate == Animal::DESERT ? "Пустыня" :
+                enc->climate == Animal::FOREST ? "Лес" :
+                enc->climate == Animal::ARCTIC ? "Арктика" : "Океан")
+                << ", Животных: " << enc->animals.size() << "/" << enc->capacity << "\n";
+        }
+
+        int enclosureChoice = getIntegerInput("Введите номер вольера: ");
+        if (enclosureChoice <= 0 || enclosureChoice > suitableEnclosures.size()) {
+            cout << "Неверный номер вольера!\n";
+            break;
+        }
+
+        Enclosure* selectedEnclosure = suitableEnclosures[enclosureChoice - 1];
+        zoo.buyAnimal(choice - 1, selectedEnclosure->index, name);
+
+        cout << "Животное \"" << selectedAnimal.name << "\" успешно добавлено в вольер!\n";
+
+        break;
+    }
+    case 2: { // Продажа животного
+        cout << "\n--- Продажа животных ---\n";
+        if (zoo.enclosures.empty()) {
+            cout << "У вас нет вольеров!\n";
+            break;
+        }
+
+        // Вывод списка вольеров
+        int index = 1;
+        for (auto& enc : zoo.enclosures) {
+            string climateName;
+            switch (enc.climate) {
+            case Animal::DESERT: climateName = "Пустыня"; break;
+            case Animal::FOREST: climateName = "Лес"; break;
+            case Animal::ARCTIC: climateName = "Арктика"; break;
+            case Animal::OCEAN: climateName = "Океан"; break;
+            }
+            cout << index << ". Климат: " << climateName
+                << ", Животных: " << enc.animals.size() << "/" << enc.capacity << "\n";
+            index++;
+        }
+
+        // Выбор вольера
+        int enclosureChoice = getIntegerInput("Введите номер вольера: ");
+        if (enclosureChoice <= 0 || enclosureChoice > zoo.enclosures.size()) {
+            cout << "Неверный номер вольера!\n";
+            break;
+        }
+
+        auto encIt = zoo.enclosures.begin();
+        advance(encIt, enclosureChoice - 1);
+
+        // Проверка, есть ли животные в вольере
+        if (encIt->animals.empty()) {
+            cout << "В этом вольере нет животных!\n";
+            break;
+        }
+
+        // Вывод списка животных в выбранном вольере
+        cout << "\nЖивотные в вольере:\n";
+        for (size_t i = 0; i < encIt->animals.size(); ++i) {
+            Animal animal = encIt->animals.get(i, zoo.day);
+            cout << i + 1 << ". " << animal.name << ", Возраст: " << animal.ageInDays
+                << ", Вес: " << animal.weight << ", Цена: " << animal.calculatePrice() << "\n";
+        }
+
+        // Выбор животного
+        int animalChoice = getIntegerInput("Введите номер животного для продажи: ");
+        if (animalChoice <= 0 || animalChoice > encIt->animals.size()) {
+            cout << "Неверный номер животного!\n";
+            break;
+        }
+
+        size_t animalIndex = animalChoice - 1;
+        Animal animal = encIt->animals.get(animalIndex, zoo.day);
+
+        // Расчет цены продажи
+        int sellPrice = animal.calculateSalePrice();
+
+        // Вывод информации о продаже
+        cout << "Животное \"" << animal.name << "\" можно продать за " << sellPrice << " монет.\n";
+        cout << "Вы уверены, что хотите продать это животное?\n";
+        cout << "1. Да\n2. Нет\n";
+        int confirm = getIntegerInput("Ваш выбор: ");
+
+        // Подтверждение продажи
+        if (confirm != 1) {
+            cout << "Продажа отменена.\n";
+            break;
+        }
+
+        // Сохраняем имя животного перед удалением
+        string animalName = animal.name;
+
+        // Удаление животного и добавление денег
+        zoo.sellAnimal(encIt->index, animalIndex);
+
+        // Вывод сообщения об успешной продаже
+        cout << "Животное \"" << animalName << "\" продано за " << sellPrice << " монет.\n";
+        break;
+    }
+    case 3: { // Просмотреть животных
+        cout << "Список животных:\n";
+        for (auto& enc : zoo.enclosures) {
+            for (size_t i = 0; i < enc.animals.size(); ++i) {
+                Animal animal = enc.animals.get(i, zoo.day);
+                string climateName;
+                switch (animal.climate()) {
+                case Animal::DESERT: climateName = "Пустыня"; break;
+                case Animal::FOREST: climateName = "Лес"; break;
+                case Animal::ARCTIC: climateName = "Арктика"; break;
+                case Animal::OCEAN: climateName = "Океан"; break;
+                }
+                cout << "- " << animal.name << ", "
+                    << "Вид: " << animal.speciesName() << ", "
+                    << animal.ageInDays << " дней, "
+                    << animal.weight << " кг, "
+                    << (animal.isCarnivore() ? "Хищник" : "Травоядное") << ", "
+                    << (animal.isAquatic() ? "Водоплавающее" : "Земноводное") << ", "
+                    << "Климат: " << climateName << ", "
+                    << "Пол: " << (animal.gender() == 'M' ? "М" : "Ж") << ", ";
+                animal.printParents(zoo);
+                cout << "\n";
+            }
+        }
+        break;
+    }
+    case 4: { // Лечение животного
+        cout << "\n--- Лечение животных ---\n";
+        if (zoo.enclosures.empty()) {
+            cout << "У вас нет вольеров!\n";
+            break;
+        }
+
+        // Вывод списка вольеров
+        int index = 1;
+        for (auto& enc : zoo.enclosures) {
+            string climateName;
+            switch (enc.climate) {
+            case Animal::DESERT: climateName = "Пустыня"; break;
+            case Animal::FOREST: climateName = "Лес"; break;
+            case Animal::ARCTIC: climateName = "Арктика"; break;
+            case Animal::OCEAN: climateName = "Океан"; break;
+            }
+            cout << index << ". Климат: " << climateName
+                << ", Животных: " << enc.animals.size() << "/" << enc.capacity << "\n";
+            index++;
+        }
+
+        // Выбор вольера
+        int enclosureChoice = getIntegerInput("Введите номер вольера: ");
+        if (enclosureChoice <= 0 || enclosureChoice > zoo.enclosures.size()) {
+            cout << "Неверный номер вольера!\n";
+            break;
+        }
+
+        auto encIt = zoo.enclosures.begin();
+        advance(encIt, enclosureChoice - 1);
+
+        // Проверка, есть ли больные животные в вольере
+        if (encIt->animals.counts().infected == 0) {
+            cout << "В этом вольере нет больных животных!\n";
+            break;
+        }
+
+        // Вывод списка больных животных
+        cout << "\nБольные животные в вольере:\n";
+        index = 1;
+        const AnimalStore& animals = encIt->animals;
+        for (size_t i = 0; i < animals.size(); ++i) {
+            if (animals.isInfected(i)) {
+                cout << index << ". " << animals.name(i) << ", Возраст: " << animals.age(i, zoo.day)
+                    << ", Вес: " << animals.weights[i] << "\n";
+                index++;
+            }
+        }
+
+        // Выбор животного для лечения
+        int animalChoice = getIntegerInput("Введите номер животного для лечения: ");
+        if (animalChoice <= 0 || animalChoice > index - 1) {
+            cout << "Неверный номер животного!\n";
             break;
         }
 
-        auto it = zoo.employees.begin();
-        while (it != zoo.employees.end()) {
-            if (it->position == "Директор") {
-                ++it; // Пропускаем директора
-                continue;
+        int count = 0;
+        for (size_t i = 0; i < animals.size(); ++i) {
+            if (animals.isInfected(i)) {
+                count++;
+                if (count == animalChoice) {
+                    zoo.cureAnimal(animals.ids[i]); // Вызов метода лечения
+                    break;
+                }
             }
-            if (choice == 1) {
-                zoo.employees.erase(it);
-                cout << "Сотрудник уволен!\n";
-                break;
+        }
+        break;
+    }
+    case 5: { // Обновление рынка
+        zoo.refreshAnimalMarket(zoo.day);
+        break;
+    }
+    case 6: { // Размножение животных
+        cout << "\n--- Размножение животных ---\n";
+        if (zoo.enclosures.empty()) {
+            cout << "У вас нет вольеров!\n";
+            break;
+        }
+
+        // Вывод списка вольеров
+        int index = 1;
+        for (auto& enc : zoo.enclosures) {
+            string climateName;
+            switch (enc.climate) {
+            case Animal::DESERT: climateName = "Пустыня"; break;
+            case Animal::FOREST: climateName = "Лес"; break;
+            case Animal::ARCTIC: climateName = "Арктика"; break;
+            case Animal::OCEAN: climateName = "Океан"; break;
             }
-            --choice;
-            ++it;
+            cout << index << ". Климат: " << climateName
+                << ", Животных: " << enc.animals.size() << "/" << enc.capacity << "\n";
+            index++;
+        }
+
+        // Выбор вольера
+        int enclosureChoice = getIntegerInput("Введите номер вольера: ");
+        if (enclosureChoice <= 0 || enclosureChoice > zoo.enclosures.size()) {
+            cout << "Неверный номер вольера!\n";
+            break;
+        }
+
+        auto encIt = zoo.enclosures.begin();
+        advance(encIt, enclosureChoice - 1);
+
+        // Вызов метода размножения
+        encIt->breedAnimals(zoo);
+        break;
+    }
+    case 7: { // Изменение имени животного
+        cout << "--- Изменение имени животного ---\n";
+        renameAnimal(zoo);
+        break;
+    }
+    case 0:
+        return;
+    }
+}
+/**
+ * @brief Управляет ресурсами зоопарка.
+ * @param zoo Ссылка на объект зоопарка
+ */
+void manageResources(Zoo& zoo) {
+    cout << "\n--- Управление ресурсами ---\n";
+    cout << "1. Купить еду\n";
+    cout << "2. Заказать рекламу\n";
+    cout << "0. Назад\n";
+
+    int choice = getIntegerInput("Выберите действие: ");
+    switch (choice) {
+    case 1: {
+        cout << "\nПокупка еды:\n";
+        int amount = getIntegerInput("Сколько кг еды хотите купить? ");
+        if (amount <= 0) {
+            cout << "Неверное количество!\n";
+            break;
+        }
+
+        int moneyBefore = zoo.money;
+        if (!zoo.buyFood(amount)) {
+            cout << "Недостаточно средств для покупки!\n";
+            break;
+        }
+        cout << "Куплено " << amount << " кг еды за " << moneyBefore - zoo.money << " монет.\n";
+        break;
+    }
+    case 2: {
+        cout << "Стоимость одной единицы популярности: " << Zoo::COST_PER_POPULARITY << " монет\n";
+
+        int cost = getIntegerInput("Введите сумму для рекламной кампании: ");
+        if (cost <= 0) {
+            cout << "Неверная сумма!\n";
+            break;
+        }
+
+        int popularityIncrease = zoo.advertise(cost);
+        if (popularityIncrease >= 0) {
+            cout << "Популярность увеличена на " << popularityIncrease << "!\n";
+        }
+        else {
+            cout << "Недостаточно средств!\n";
+        }
+        break;
+    }
+    case 0:
+        return;
+    }
+}
+/**
+ * @brief Показывает журнал событий за прошлый и текущий день.
+ * @param zoo Зоопарк
+ */
+void showEventLog(const Zoo& zoo) {
+    cout << "\n--- Журнал событий ---\n";
+    size_t first = zoo.events.size();
+    while (first > 0 && zoo.events[first - 1].day + 1 >= static_cast<uint32_t>(zoo.day)) first--;
+    if (first == zoo.events.size()) {
+        cout << "Событий нет.\n";
+    }
+    for (size_t i = first; i < zoo.events.size(); ++i) {
+        printEvent(cout, zoo.events[i], &zoo);
+    }
+}
+
+/**
+ * @brief Печатает файл журнала событий текстом.
+ * @param path Путь к файлу, записанному EventLog::spillTo
+ * @return Код завершения программы.
+ */
+int printEventFile(const string& path) {
+    for (const EventRecord& event : EventLog::readFile(path)) {
+        printEvent(cout, event, nullptr);
+    }
+    return 0;
+}
+
+/**
+ * @brief Печатает столбцовый файл показателей в CSV.
+ * @param path Путь к файлу, записанному MetricsFile
+ * @return Код завершения программы.
+ */
+int printMetricsFile(const string& path) {
+    MetricsFile::printCsv(path, cout);
+    return 0;
+}
+
+/**
+ * @brief Параметры генератора больших зоопарков для нагрузочных прогонов.
+ */
+struct ZooGeneratorOptions {
+    int enclosuresPerClimate = 1;   ///< Вольеров каждого климата
+    int capacity = 100;             ///< Вместимость вольера
+    double fill = 0.8;              ///< Доля заполнения вольеров
+    double carnivores = 0.5;        ///< Доля вольеров с хищниками (смешивать с травоядными нельзя)
+    double infected = 0.0;          ///< Доля заражённых животных
+    int minAge = 0;                 ///< Наименьший возраст; 0 — возраст из generateRandomAnimal
+    int maxAge = 0;                 ///< Наибольший возраст
+    int staff[EMPLOYEE_POSITION_COUNT] = { 0, 0, 0 }; ///< Сотрудников каждой должности EMPLOYEE_POSITIONS
+};
+
+/**
+ * @brief Разбирает параметры генератора вида ключ=значение.
+ * @details Ключи: enclosures (вольеров на климат), capacity, fill, carnivores, infected,
+ * age=мин-макс, staff=уборщики,ветеринары,кормильцы. Не указанные ключи берутся по умолчанию.
+ * @param in Поток с параметрами
+ * @return Разобранные параметры.
+ * @throws runtime_error Если ключ неизвестен или значение вне допустимого диапазона.
+ */
+ZooGeneratorOptions parseGeneratorSpec(istream& in) {
+    ZooGeneratorOptions options;
+    string item;
+    while (in >> item) {
+        size_t eq = item.find('=');
+        if (eq == string::npos) throw runtime_error("ожидается 'ключ=значение', получено '" + item + "'");
+        string key = item.substr(0, eq);
+        istringstream value(item.substr(eq + 1));
+        char separator;
+        bool ok;
+        if (key == "enclosures") ok = bool(value >> options.enclosuresPerClimate) && options.enclosuresPerClimate >= 0;
+        else if (key == "capacity") ok = bool(value >> options.capacity) && options.capacity > 0;
+        else if (key == "fill") ok = bool(value >> options.fill) && options.fill >= 0 && options.fill <= 1;
+        else if (key == "carnivores") ok = bool(value >> options.carnivores) && options.carnivores >= 0 && options.carnivores <= 1;
+        else if (key == "infected") ok = bool(value >> options.infected) && options.infected >= 0 && options.infected <= 1;
+        else if (key == "age") {
+            ok = bool(value >> options.minAge >> separator >> options.maxAge) && separator == '-'
+                && options.minAge > 0 && options.minAge <= options.maxAge && options.maxAge <= UINT16_MAX;
+        }
+        else if (key == "staff") {
+            ok = bool(value >> options.staff[0]);
+            for (int p = 1; p < EMPLOYEE_POSITION_COUNT && ok; ++p) {
+                ok = bool(value >> separator >> options.staff[p]) && separator == ',';
+            }
+            for (int p = 0; p < EMPLOYEE_POSITION_COUNT; ++p) ok = ok && options.staff[p] >= 0;
+        }
+        else throw runtime_error("неизвестный параметр генератора '" + key + "'");
+        if (!ok) throw runtime_error("недопустимое значение '" + item + "'");
+    }
+    return options;
+}
+
+/**
+ * @brief Достраивает зоопарк случайными вольерами, животными и сотрудниками.
+ * @details Животные берутся из generateRandomAnimal и подгоняются под вольер: климат,
+ * тип питания вольера, возраст и заражение по параметрам. Каждый вольер заполняется
+ * одним блоком (Enclosure::insertAnimals) из собственного потока случайных чисел,
+ * поэтому 10 миллионов животных строятся за секунды, а результат зависит только от зерна.
+ * Хищные вольеры равномерно распределены между климатами.
+ * @param zoo Зоопарк, в который добавляются вольеры и сотрудники
+ * @param options Параметры генератора
+ */
+void generateZoo(Zoo& zoo, const ZooGeneratorOptions& options) {
+    const Animal::Climate climates[] = { Animal::DESERT, Animal::FOREST, Animal::ARCTIC, Animal::OCEAN };
+    int total = 4 * options.enclosuresPerClimate;
+    size_t perEnclosure = min(static_cast<size_t>(options.capacity),
+        static_cast<size_t>(llround(options.capacity * options.fill)));
+    zoo.enclosures.reserve(zoo.enclosures.size() + total);
+    for (int k = 0; k < total; ++k) {
+        Animal::Climate climate = climates[k % 4];
+        // Хищный вольер, если на нём доля хищных вольеров переходит через целое
+        bool carnivore = llround((k + 1) * options.carnivores) > llround(k * options.carnivores);
+        Enclosure& enc = zoo.addEnclosure(climate, options.capacity);
+        Rng rng = Rng::stream(zoo.seed, RNG_GENERATOR, enc.index);
+        enc.insertAnimals(perEnclosure, [&](size_t) {
+            Animal animal = generateRandomAnimal(rng);
+            if (animal.climate() != climate) {
+                animal.species = getRandomSpecies(climate, rng);
+                animal.bits = static_cast<uint8_t>((animal.bits & ~(Animal::CLIMATE_MASK | Animal::AQUATIC_BIT)) | climate);
+                if (climate == Animal::OCEAN) animal.bits |= Animal::AQUATIC_BIT;
+            }
+            if (carnivore) animal.bits |= Animal::CARNIVORE_BIT;
+            else animal.bits &= ~Animal::CARNIVORE_BIT;
+            if (options.minAge > 0) {
+                animal.ageInDays = static_cast<uint16_t>(options.minAge + rng.below(options.maxAge - options.minAge + 1));
+            }
+            if (options.infected > 0) animal.setInfected(rng.uniform() < options.infected);
+            return animal;
+        });
+    }
+    for (int p = 0; p < EMPLOYEE_POSITION_COUNT; ++p) {
+        const EmployeePosition& pos = EMPLOYEE_POSITIONS[p];
+        for (int i = 1; i <= options.staff[p]; ++i) {
+            zoo.hireEmployee(string(pos.title) + " " + to_string(i), pos.title, pos.salary, pos.maxAnimals);
+        }
+    }
+}
+
+/**
+ * @brief Загружает начальное устройство зоопарка из текстового файла.
+ * @details Каждая строка файла — одна команда, строки с '#' в начале пропускаются:
+ * - enclosure <климат 0-3> <вместимость> [уровень]
+ * - animal <номер вольера> <вид|*> <возраст> <вес> <M|F> <хищник 0|1> [имя]
+ *   (пробелы в названии вида заменяются на '_', '*' — случайный вид климата вольера;
+ *   возраст и вес от 0 до 65535)
+ * - employee <должность 1-3> <имя>
+ * - food <кг>
+ * - popularity <значение>
+ * - generate [ключ=значение ...] — большой случайный зоопарк (см. parseGeneratorSpec)
+ * @param zoo Зоопарк, в который загружается устройство
+ * @param path Путь к файлу
+ * @throws runtime_error Если файл не открывается или содержит ошибку.
+ */
+void loadZooLayout(Zoo& zoo, const string& path) {
+    ifstream file(path);
+    if (!file) {
+        throw runtime_error("Не удалось открыть файл устройства зоопарка: " + path);
+    }
+
+    string line;
+    int lineNumber = 0;
+    while (getline(file, line)) {
+        lineNumber++;
+        istringstream in(line);
+        string command;
+        if (!(in >> command) || command[0] == '#') continue;
+
+        string where = path + ":" + to_string(lineNumber) + ": ";
+        if (command == "enclosure") {
+            int climate, capacity, level = 1;
+            if (!(in >> climate >> capacity) || climate < Animal::DESERT || climate > Animal::OCEAN || capacity <= 0) {
+                throw runtime_error(where + "ожидается 'enclosure <климат 0-3> <вместимость> [уровень]'");
+            }
+            in >> level;
+            Enclosure& enc = zoo.addEnclosure(static_cast<Animal::Climate>(climate), capacity);
+            for (int i = 1; i < level && enc.upgrade(0); ++i) {}
+        }
+        else if (command == "animal") {
+            int enclosure, age, weight, carnivore;
+            string species, gender, name;
+            if (!(in >> enclosure >> species >> age >> weight >> gender >> carnivore)
+                || enclosure <= 0 || static_cast<size_t>(enclosure) > zoo.enclosures.size() || (gender != "M" && gender != "F")
+                || age < 0 || age > UINT16_MAX || weight < 0 || weight > UINT16_MAX) {
+                throw runtime_error(where + "ожидается 'animal <вольер> <вид|*> <возраст> <вес> <M|F> <хищник 0|1> [имя]'");
+            }
+            getline(in >> ws, name);
+
+            Enclosure& enc = zoo.enclosures[enclosure - 1];
+            SpeciesId speciesId;
+            if (species == "*") {
+                speciesId = getRandomSpecies(enc.climate, zoo.marketRng);
+            }
+            else {
+                replace(species.begin(), species.end(), '_', ' ');
+                speciesId = SpeciesTable::instance().intern(species);
+            }
+            Animal animal(name, speciesId, age, weight, enc.climate, carnivore != 0, gender[0],
+                enc.climate == Animal::OCEAN ? Animal::AQUATIC : Animal::LAND);
+            if (enc.addAnimal(animal) == NO_ANIMAL) {
+                throw runtime_error(where + "животное не помещается в вольер " + to_string(enclosure));
+            }
+        }
+        else if (command == "generate") {
+            try {
+                generateZoo(zoo, parseGeneratorSpec(in));
+            }
+            catch (const exception& e) {
+                throw runtime_error(where + e.what());
+            }
+        }
+        else if (command == "employee") {
+            int position;
+            string name;
+            if (!(in >> position) || position < 1 || position > EMPLOYEE_POSITION_COUNT) {
+                throw runtime_error(where + "ожидается 'employee <должность 1-3> <имя>'");
+            }
+            getline(in >> ws, name);
+            const EmployeePosition& pos = EMPLOYEE_POSITIONS[position - 1];
+            zoo.hireEmployee(name, pos.title, pos.salary, pos.maxAnimals);
         }
-        break;
-    }
-    case 3: {
-        cout << "\nСписок сотрудников:\n";
-        for (auto& emp : zoo.employees) {
-            cout << "- " << emp.name << " (" << emp.position << ") Зарплата: "
-                << emp.salary << ", Обслуживает: " << emp.currentAnimals << "/"
-                << emp.maxAnimals << " животных\n";
+        else if (command == "food") {
+            if (!(in >> zoo.food)) throw runtime_error(where + "ожидается 'food <кг>'");
+        }
+        else if (command == "popularity") {
+            if (!(in >> zoo.popularity)) throw runtime_error(where + "ожидается 'popularity <значение>'");
+        }
+        else {
+            throw runtime_error(where + "неизвестная команда '" + command + "'");
         }
-        break;
-    }
-    case 0:
-        return;
     }
 }
+
+/// Признак файла снимка
+const char SNAPSHOT_MAGIC[8] = { 'Z', 'O', 'O', 'S', 'N', 'A', 'P', '\0' };
+/// Версия формата снимка; меняется при любом изменении раскладки
+const uint32_t SNAPSHOT_VERSION = 1;
+/// Метка порядка байтов: снимок читается только на машине с тем же порядком
+const uint32_t SNAPSHOT_BYTE_ORDER = 0x01020304;
+
 /**
- * @brief Управляет вольерами зоопарка.
- * @param zoo Ссылка на объект зоопарка
+ * @brief Записывает состояние генератора в снимок.
  */
-void manageEnclosures(Zoo& zoo) {
-    cout << "\n--- Управление вольерами ---\n";
-    cout << "1. Построить вольер\n";
-    cout << "2. Улучшить вольер\n";
-    cout << "3. Просмотреть вольеры\n";
-    cout << "0. Назад\n";
+void saveRng(SnapshotWriter& out, const Rng& rng) {
+    out.pod(rng.key);
+    out.pod(rng.counter);
+}
 
-    int choice = getIntegerInput("Выберите действие: ");
-    switch (choice) {
-    case 1: {
-        cout << "\n--- Создание нового вольера ---\n";
-        cout << "Выберите климат для вольера:\n";
-        cout << "0. Пустыня (Множитель цены: 1.2)\n";
-        cout << "1. Лес (Множитель цены: 1.0)\n";
-        cout << "2. Арктика (Множитель цены: 1.5)\n";
-        cout << "3. Океан (Множитель цены: 1.8)\n";
-        Animal::Climate climate = static_cast<Animal::Climate>(getIntegerInput("Ваш выбор: "));
+/**
+ * @brief Читает состояние генератора из снимка.
+ */
+void loadRng(SnapshotReader& in, Rng& rng) {
+    in.pod(rng.key);
+    in.pod(rng.counter);
+}
 
-        int capacity = getIntegerInput("Вместимость (Одно место = 50 монет): ");
+/**
+ * @brief Записывает двоичный снимок зоопарка: всё, что нужно, чтобы продолжить игру с того же места.
+ * @details Столбцы животных пишутся целиком, выровненными, чтобы loadZooSnapshot брал их
+ * прямо из отображённого файла. Виды записываются по названиям: номера видов зависят
+ * от порядка, в котором процесс их встретил.
+ * @param zoo Зоопарк
+ * @param path Путь к файлу снимка
+ * @throws runtime_error Если файл не записывается.
+ */
+void saveZooSnapshot(const Zoo& zoo, const string& path) {
+    ZOO_TRACE_SCOPE("saveZooSnapshot", "day", zoo.day);
+    SnapshotWriter out(path);
+    out.pod(SNAPSHOT_MAGIC);
+    out.pod(SNAPSHOT_VERSION);
+    out.pod(SNAPSHOT_BYTE_ORDER);
+
+    const SpeciesTable& table = SpeciesTable::instance();
+    out.pod(static_cast<uint64_t>(table.size()));
+    for (size_t i = 0; i < table.size(); ++i) out.str(table.name(static_cast<SpeciesId>(i)));
+
+    out.str(zoo.name);
+    out.pod(zoo.money); out.pod(zoo.food); out.pod(zoo.popularity);
+    out.pod(zoo.day); out.pod(zoo.animalsBoughtToday); out.pod(zoo.seed);
+    for (const Rng* rng : { &zoo.eventsRng, &zoo.marketRng, &zoo.feedingRng, &zoo.popularityRng, &zoo.breedingRng }) {
+        saveRng(out, *rng);
+    }
+    out.pod(zoo.deaths);
+    out.pod(zoo.tickMode); out.pod(zoo.spreadMode); out.pod(zoo.agingMode);
+
+    out.pod(static_cast<uint64_t>(zoo.enclosures.size()));
+    for (const Enclosure& enc : zoo.enclosures) {
+        out.pod(enc.climate); out.pod(enc.capacity); out.pod(enc.dailyCost); out.pod(enc.level);
+        saveRng(out, enc.agingRng);
+        saveRng(out, enc.infectionRng);
+        saveRng(out, enc.spreadRng);
+        enc.animals.save(out);
+    }
+    zoo.registry.save(out);
 
-        // Создаем временный вольер для расчета стоимости
-        Enclosure newEnclosure(climate, capacity);
-        int cost = newEnclosure.calculateCost();
+    out.pod(static_cast<uint64_t>(zoo.employees.size()));
+    for (const Employee& employee : zoo.employees) {
+        out.str(employee.name);
+        out.str(employee.position);
+        out.pod(employee.salary); out.pod(employee.maxAnimals); out.pod(employee.currentAnimals);
+    }
+    out.pod(static_cast<uint64_t>(zoo.animalMarket.size()));
+    for (const Animal& animal : zoo.animalMarket) {
+        out.str(animal.name);
+        out.pod(animal.parents.first); out.pod(animal.parents.second); out.pod(animal.id); out.pod(animal.species);
+        out.pod(animal.ageInDays); out.pod(animal.weight); out.pod(animal.bits);
+    }
+    zoo.deathCalendar.save(out);
+    zoo.events.save(out);
+    out.finish();
+}
 
-        cout << "Стоимость вольера: " << cost << " монет\n";
-        cout << "Хотите построить этот вольер?\n";
-        cout << "1. Да\n2. Нет\n";
-        int confirm = getIntegerInput("Ваш выбор: ");
+/**
+ * @brief Восстанавливает зоопарк из двоичного снимка.
+ * @details Файл отображается в память, столбцы животных копируются из него целиком,
+ * без разбора по записям. Если номера видов в этом процессе другие, столбец видов
+ * перенумеровывается. Прежнее содержимое зоопарка заменяется; файл журнала событий
+ * (spillTo) к зоопарку не привязывается.
+ * @param zoo Зоопарк, в который загружается снимок
+ * @param path Путь к файлу снимка
+ * @throws runtime_error Если файл не открывается, другой версии или повреждён.
+ */
+void loadZooSnapshot(Zoo& zoo, const string& path) {
+    ZOO_TRACE_SCOPE("loadZooSnapshot");
+    MappedFile file(path);
+    SnapshotReader in(file.data(), file.size());
+    char magic[sizeof(SNAPSHOT_MAGIC)];
+    in.pod(magic);
+    if (memcmp(magic, SNAPSHOT_MAGIC, sizeof(magic)) != 0) {
+        throw runtime_error("Файл не является снимком зоопарка: " + path);
+    }
+    uint32_t version = in.pod<uint32_t>();
+    if (version != SNAPSHOT_VERSION) {
+        throw runtime_error("Версия снимка " + to_string(version) + " не поддерживается (ожидается "
+            + to_string(SNAPSHOT_VERSION) + "): " + path);
+    }
+    if (in.pod<uint32_t>() != SNAPSHOT_BYTE_ORDER) {
+        throw runtime_error("Снимок записан на машине с другим порядком байтов: " + path);
+    }
 
-        if (confirm != 1) {
-            cout << "Строительство отменено.\n";
-            break;
+    SpeciesTable& table = SpeciesTable::instance();
+    vector<SpeciesId> speciesMap(static_cast<size_t>(in.pod<uint64_t>()));
+    bool sameSpecies = true;
+    for (size_t i = 0; i < speciesMap.size(); ++i) {
+        speciesMap[i] = table.intern(in.str());
+        sameSpecies = sameSpecies && speciesMap[i] == i;
+    }
+    auto mapSpecies = [&](SpeciesId& species) {
+        if (species >= speciesMap.size()) throw runtime_error("Снимок повреждён: неизвестный вид");
+        species = speciesMap[species];
+    };
+
+    zoo.name = in.str();
+    in.pod(zoo.money); in.pod(zoo.food); in.pod(zoo.popularity);
+    in.pod(zoo.day); in.pod(zoo.animalsBoughtToday); in.pod(zoo.seed);
+    for (Rng* rng : { &zoo.eventsRng, &zoo.marketRng, &zoo.feedingRng, &zoo.popularityRng, &zoo.breedingRng }) {
+        loadRng(in, *rng);
+    }
+    in.pod(zoo.deaths);
+    in.pod(zoo.tickMode); in.pod(zoo.spreadMode); in.pod(zoo.agingMode);
+
+    zoo.enclosures.clear();
+    zoo.animalCounts = AnimalCounts();
+    size_t enclosureCount = static_cast<size_t>(in.pod<uint64_t>());
+    for (size_t e = 0; e < enclosureCount; ++e) {
+        Animal::Climate climate = in.pod<Animal::Climate>();
+        int capacity = in.pod<int>();
+        Enclosure& enc = zoo.addEnclosure(climate, capacity);
+        in.pod(enc.dailyCost); in.pod(enc.level);
+        loadRng(in, enc.agingRng);
+        loadRng(in, enc.infectionRng);
+        loadRng(in, enc.spreadRng);
+        enc.animals.load(in);
+        if (!sameSpecies) {
+            for (SpeciesId& species : enc.animals.species.edit()) mapSpecies(species);
         }
+        zoo.animalCounts += enc.animals.counts();
+    }
+    zoo.registry.load(in);
+
+    zoo.employees.clear();
+    zoo.payroll = 0;
+    size_t employeeCount = static_cast<size_t>(in.pod<uint64_t>());
+    for (size_t i = 0; i < employeeCount; ++i) {
+        string name = in.str();
+        string position = in.str();
+        int salary = in.pod<int>();
+        int maxAnimals = in.pod<int>();
+        zoo.hireEmployee(name, position, salary, maxAnimals).currentAnimals = in.pod<int>();
+    }
+    zoo.animalMarket.clear();
+    size_t marketCount = static_cast<size_t>(in.pod<uint64_t>());
+    for (size_t i = 0; i < marketCount; ++i) {
+        Animal animal("", 0, 0, 0, Animal::DESERT, false, 'F', Animal::LAND);
+        animal.name = in.str();
+        in.pod(animal.parents.first); in.pod(animal.parents.second); in.pod(animal.id); in.pod(animal.species);
+        in.pod(animal.ageInDays); in.pod(animal.weight); in.pod(animal.bits);
+        mapSpecies(animal.species);
+        zoo.animalMarket.push_back(move(animal));
+    }
+    zoo.deathCalendar.load(in);
+    zoo.events.load(in);
+}
 
-        if (zoo.money < cost) {
-            cout << "Недостаточно средств для строительства!\n";
-            break;
+/**
+ * @brief Пул потоков с перехватом задач (work stealing).
+ * @details У каждого рабочего потока своя очередь: свои задачи он берёт с конца,
+ * а опустев, забирает задачи с начала чужих очередей. Так потоки, чьи прогоны
+ * закончились раньше (например, банкротством), догружаются работой соседей.
+ */
+class WorkStealingPool {
+public:
+    /**
+     * @brief Запускает рабочие потоки.
+     * @param threadCount Количество потоков; 0 — по числу ядер
+     */
+    explicit WorkStealingPool(unsigned threadCount) {
+        if (threadCount == 0) threadCount = max(1u, thread::hardware_concurrency());
+        for (unsigned i = 0; i < threadCount; ++i) {
+            queues.push_back(make_unique<WorkerQueue>());
+        }
+        for (unsigned i = 0; i < threadCount; ++i) {
+            workers.emplace_back([this, i]() { workerLoop(i); });
         }
-
-        zoo.enclosures.emplace_back(climate, capacity); //emplace back создаёт объект непосредственно в контейнере, избегая лишних копирований
-        zoo.money -= cost;
-        cout << "Вольер успешно построен!\n";
-        break;
     }
-    case 2: {
-        cout << "\nУлучшение вольера:\n";
-        int index = 1;
-        for (auto& enc : zoo.enclosures) {
-            string climate;
-            switch (enc.climate) {
-            case Animal::DESERT: climate = "Пустыня"; break;
-            case Animal::FOREST: climate = "Лес"; break;
-            case Animal::ARCTIC: climate = "Арктика"; break;
-            case Animal::OCEAN: climate = "Океан"; break;
-            }
-            cout << index << ". Климат: " << climate
-                << ", Уровень: " << enc.level
-                << ", Животных: " << enc.animals.size() << "/" << enc.capacity
-                << ", Расходы в день: " << enc.dailyCost << "\n";
-            index++;
+    /**
+     * @brief Дожидается оставшихся задач и останавливает потоки.
+     */
+    ~WorkStealingPool() {
+        wait();
+        {
+            lock_guard<mutex> guard(stateLock);
+            stopping = true;
         }
-
-        int choice = getIntegerInput("Введите номер вольера для улучшения: ");
-        if (choice <= 0 || choice > zoo.enclosures.size()) {
-            cout << "Неверный номер!\n";
-            break;
+        wakeUp.notify_all();
+        for (auto& worker : workers) {
+            worker.join();
         }
+    }
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
 
-        auto it = zoo.enclosures.begin();
-        advance(it, choice - 1); // Перемещаем итератор
-
-        // Рассчитываем стоимость улучшения
-        int upgradeCost = it->capacity * 5 * (it->level + 1);
-        cout << "Стоимость улучшения: " << upgradeCost << " монет\n";
-        cout << "Хотите улучшить этот вольер?\n";
-        cout << "1. Да\n2. Нет\n";
-        int confirm = getIntegerInput("Ваш выбор: ");
-
-        if (confirm != 1) {
-            cout << "Улучшение отменено.\n";
-            break;
+    /**
+     * @brief Количество рабочих потоков.
+     */
+    size_t threadCount() const {
+        return workers.size();
+    }
+    /**
+     * @brief Ставит задачу в очередь; очереди потоков заполняются по кругу.
+     * @param task Задача
+     */
+    void submit(function<void()> task) {
+        WorkerQueue& queue = *queues[nextQueue];
+        nextQueue = (nextQueue + 1) % queues.size();
+        // Счётчики растут до появления задачи в очереди: иначе работник может взять её
+        // и уменьшить их раньше, и queued на миг перейдёт через ноль
+        unfinished++;
+        {
+            lock_guard<mutex> guard(stateLock);
+            queued++;
         }
-
-        if (zoo.money < upgradeCost) {
-            cout << "Недостаточно средств для улучшения!\n";
-            break;
+        {
+            lock_guard<mutex> guard(queue.lock);
+            queue.tasks.push_back(move(task));
         }
+        wakeUp.notify_one();
+    }
+    /**
+     * @brief Ждёт завершения всех поставленных задач.
+     */
+    void wait() {
+        unique_lock<mutex> guard(stateLock);
+        allDone.wait(guard, [this]() { return unfinished == 0; });
+    }
 
-        if (it->upgrade(upgradeCost)) {
-            zoo.money -= upgradeCost;
-            cout << "Вольер успешно улучшен до уровня " << it->level << "!\n";
+private:
+    /**
+     * @brief Очередь задач одного рабочего потока.
+     */
+    struct WorkerQueue {
+        mutex lock;                      ///< Защищает очередь
+        deque<function<void()>> tasks;   ///< Задачи потока
+    };
+
+    vector<unique_ptr<WorkerQueue>> queues; ///< Очереди по одной на поток
+    vector<thread> workers;                 ///< Рабочие потоки
+    size_t nextQueue = 0;                   ///< Очередь для следующей задачи
+    atomic<size_t> unfinished{ 0 };         ///< Поставлено, но ещё не выполнено
+    mutex stateLock;                        ///< Защищает queued и stopping
+    condition_variable wakeUp;              ///< Будит спящие потоки
+    condition_variable allDone;             ///< Сигнал для wait()
+    size_t queued = 0;                      ///< Задач в очередях
+    bool stopping = false;                  ///< Пул останавливается
+
+    /**
+     * @brief Берёт задачу: сначала из своей очереди, затем из чужих.
+     * @param self Номер потока
+     * @param task Сюда записывается задача
+     * @return true, если задача найдена.
+     */
+    bool takeTask(size_t self, function<void()>& task) {
+        {
+            WorkerQueue& own = *queues[self];
+            lock_guard<mutex> guard(own.lock);
+            if (!own.tasks.empty()) {
+                task = move(own.tasks.back());
+                own.tasks.pop_back();
+                return true;
+            }
         }
-        break;
-    }
-    case 3: {
-        cout << "\nСписок вольеров:\n";
-        int index = 1;
-        for (auto& enc : zoo.enclosures) {
-            string climate;
-            switch (enc.climate) {
-            case Animal::DESERT: climate = "Пустыня"; break;
-            case Animal::FOREST: climate = "Лес"; break;
-            case Animal::ARCTIC: climate = "Арктика"; break;
-            case Animal::OCEAN: climate = "Океан"; break;
+        for (size_t k = 1; k < queues.size(); ++k) {
+            WorkerQueue& victim = *queues[(self + k) % queues.size()];
+            lock_guard<mutex> guard(victim.lock);
+            if (!victim.tasks.empty()) {
+                task = move(victim.tasks.front());
+                victim.tasks.pop_front();
+                return true;
             }
-            cout << index << ". Климат: " << climate
-                << ", Уровень: " << enc.level
-                << ", Животных: " << enc.animals.size() << "/" << enc.capacity
-                << ", Расходы в день: " << enc.dailyCost << "\n";
-            index++;
         }
-        break;
+        return false;
     }
-    case 0:
-        return;
+    /**
+     * @brief Цикл рабочего потока.
+     * @param self Номер потока
+     */
+    void workerLoop(size_t self) {
+        Tracer::nameThread("worker " + to_string(self));
+        function<void()> task;
+        while (true) {
+            if (takeTask(self, task)) {
+                {
+                    lock_guard<mutex> guard(stateLock);
+                    queued--;
+                }
+                task();
+                task = nullptr;
+                if (--unfinished == 0) {
+                    lock_guard<mutex> guard(stateLock);
+                    allDone.notify_all();
+                }
+                continue;
+            }
+            unique_lock<mutex> guard(stateLock);
+            wakeUp.wait(guard, [this]() { return stopping || queued > 0; });
+            if (stopping && queued == 0) return;
+        }
     }
-}
+};
 
 /**
- * @brief Список видов животных для климата пустыни.
- */
-const string DESERT_SPECIES[] = { "Песчаный дракон", "Каменный скорпион", "Солнечный ящер", "Пустынный волк", "Гигантский скорпион" };
-/**
- * @brief Список видов животных для климата леса.
- */
-const string FOREST_SPECIES[] = { "Лесной феникс", "Теневой олень", "Кристальный медведь", "Искрящийся лис", "Механический единорог" };
-/**
- * @brief Список видов животных для климата арктики.
- */
-const string ARCTIC_SPECIES[] = { "Ледяной медведь", "Снежный дракон", "Арктический волк", "Хрустальная рыба", "Ледяной орёл" };
-/**
- * @brief Список видов животных для климата океана.
+ * @brief Живые показатели прогона для сервера показателей.
+ * @details Поток моделирования — единственный писатель: после каждого дня он публикует
+ * выборку через seqlock, без блокировок и выделения памяти. Читатель копирует выборку
+ * и повторяет чтение, если писатель успел её изменить.
  */
-const string OCEAN_SPECIES[] = { "Глубинный кракен", "Электрическая акула", "Морской дракон", "Водяной дух", "Океанический гигант" };
+class LiveMetrics {
+public:
+    static constexpr int TICK_BUCKETS = 8; ///< Границ гистограммы длительности дня
+    static constexpr double TICK_BOUNDS[TICK_BUCKETS] = { 1e-5, 1e-4, 1e-3, 0.01, 0.1, 1, 10, 100 }; ///< Границы, с
 
-/**
- * @brief Получает список видов животных для указанного климата.
- * @param climate Климат, для которого нужно получить виды.
- * @return Вектор строк, содержащий названия видов для указанного климата.
- */
-vector<string> getSpeciesByClimate(Animal::Climate climate) {
-    switch (climate) {
-    case Animal::DESERT:
-        return vector<string>(begin(DESERT_SPECIES), end(DESERT_SPECIES));
-    case Animal::FOREST:
-        return vector<string>(begin(FOREST_SPECIES), end(FOREST_SPECIES));
-    case Animal::ARCTIC:
-        return vector<string>(begin(ARCTIC_SPECIES), end(ARCTIC_SPECIES));
-    case Animal::OCEAN:
-        return vector<string>(begin(OCEAN_SPECIES), end(OCEAN_SPECIES));
-    default:
-        return {};
+    /**
+     * @brief Выборка показателей на конец дня.
+     */
+    struct Sample {
+        int64_t day = 0;              ///< Текущий день зоопарка
+        int64_t daysSimulated = 0;    ///< Смоделировано дней в этом прогоне
+        int64_t animals = 0;          ///< Живых животных
+        int64_t infected = 0;         ///< Заражённых
+        int64_t money = 0;            ///< Деньги
+        double seconds = 0;           ///< Время моделирования, с
+        double tickSum = 0;           ///< Суммарная длительность дней, с
+        uint64_t ticks[TICK_BUCKETS + 1] = {}; ///< Дней по корзинам; последняя — дольше всех границ
+
+        /**
+         * @brief Учитывает длительность одного дня.
+         */
+        void addTick(double duration) {
+            int bucket = 0;
+            while (bucket < TICK_BUCKETS && duration > TICK_BOUNDS[bucket]) bucket++;
+            ticks[bucket]++;
+            tickSum += duration;
+        }
+    };
+
+    /**
+     * @brief Публикует выборку; вызывает только поток моделирования.
+     */
+    void publish(const Sample& sample) {
+        uint64_t raw[WORDS];
+        memcpy(raw, &sample, sizeof(sample));
+        uint64_t seq = sequence.load(memory_order_relaxed);
+        sequence.store(seq + 1, memory_order_relaxed); // Нечётное значение: запись идёт
+        atomic_thread_fence(memory_order_release);
+        for (size_t i = 0; i < WORDS; ++i) words[i].store(raw[i], memory_order_relaxed);
+        sequence.store(seq + 2, memory_order_release);
     }
-}
+    /**
+     * @brief Читает последнюю целиком опубликованную выборку; можно из любого потока.
+     */
+    Sample read() const {
+        uint64_t raw[WORDS];
+        uint64_t before, after;
+        do {
+            before = sequence.load(memory_order_acquire);
+            for (size_t i = 0; i < WORDS; ++i) raw[i] = words[i].load(memory_order_relaxed);
+            atomic_thread_fence(memory_order_acquire);
+            after = sequence.load(memory_order_relaxed);
+        } while (before != after || (before & 1));
+        Sample sample;
+        memcpy(&sample, raw, sizeof(sample));
+        return sample;
+    }
+
+private:
+    static constexpr size_t WORDS = sizeof(Sample) / sizeof(uint64_t); ///< Выборка в 8-байтовых словах
+    static_assert(sizeof(Sample) % sizeof(uint64_t) == 0, "Выборка должна делиться на 8-байтовые слова");
 
+    atomic<uint64_t> sequence{ 0 };        ///< Чётное — выборка целая, нечётное — идёт запись
+    atomic<uint64_t> words[WORDS] = {};    ///< Выборка
+};
+
+#ifndef _WIN32
 /**
- * @brief Получает случайный вид животного для указанного климата.
- * @param climate Климат, для которого нужно получить случайный вид.
- * @return Строка с названием случайного вида.
- */
-string getRandomSpecies(Animal::Climate climate) {
-    switch (climate) {
-    case Animal::DESERT:
-        return DESERT_SPECIES[rand() % 5];
-    case Animal::FOREST:
-        return FOREST_SPECIES[rand() % 5];
-    case Animal::ARCTIC:
-        return ARCTIC_SPECIES[rand() % 5];
-    case Animal::OCEAN:
-        return OCEAN_SPECIES[rand() % 5];
-    default:
-        return "Неизвестный вид";
+ * @brief Создаёт слушающий Unix-сокет.
+ * @param path Путь к сокету; существующий файл заменяется
+ * @param backlog Длина очереди соединений
+ * @return Дескриптор сокета.
+ * @throws runtime_error Если сокет не создаётся.
+ */
+int listenUnixSocket(const string& path, int backlog) {
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path)) {
+        throw runtime_error("Слишком длинный путь к сокету: " + path);
+    }
+    strcpy(address.sun_path, path.c_str());
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    unlink(path.c_str());
+    if (listener < 0 || ::bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0
+        || listen(listener, backlog) != 0) {
+        string reason = strerror(errno);
+        if (listener >= 0) ::close(listener);
+        throw runtime_error("Не удалось открыть сокет " + path + ": " + reason);
     }
+    return listener;
 }
+
 /**
- * @brief Генерирует случайное животное.
- * @details Создает животное со случайными характеристиками, включая возраст, вес, климат, тип питания, пол и вид.
- * @return Новое случайно сгенерированное животное.
+ * @brief Флаги send для сокета клиента: закрытый клиент не должен завершать процесс сигналом SIGPIPE.
+ * @details Где нет MSG_NOSIGNAL, сигнал отключается у самого сокета (SO_NOSIGPIPE).
  */
-Animal generateRandomAnimal() {
-    Animal::Climate climates[] = { Animal::DESERT, Animal::FOREST, Animal::ARCTIC, Animal::OCEAN };
+int noSigpipeFlags(int client) {
+#ifdef MSG_NOSIGNAL
+    (void)client;
+    return MSG_NOSIGNAL;
+#else
+    int one = 1;
+    setsockopt(client, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+    return 0;
+#endif
+}
 
-    int randomAge = rand() % 20 + 1;       // Возраст от 1 до 20
-    int randomWeight = rand() % 96 + 5;  // Вес от 5 lj 100
-    Animal::Climate randomClimate = climates[rand() % 4]; // Случайный климат
-    bool isCarnivore = rand() % 2 == 0;    // Хищник или травоядное
-    char randomGender = rand() % 2 == 0 ? 'M' : 'F'; // Случайный пол
+/**
+ * @brief Сервер показателей в текстовом формате Prometheus на Unix-сокете (--metrics-socket).
+ * @details Отдельный поток принимает соединения и на каждое отвечает HTTP/1.0 с текущими
+ * показателями, поэтому их можно читать и Prometheus, и `curl --unix-socket`. Запрос
+ * не разбирается. Поток моделирования с сервером не синхронизируется: показатели
+ * читаются из LiveMetrics и счётчиков выделений памяти.
+ */
+class MetricsServer {
+public:
+    /**
+     * @brief Создаёт сокет и запускает поток сервера.
+     * @param socketPath Путь к сокету; существующий файл заменяется
+     * @param source Показатели прогона; должны пережить сервер
+     * @throws runtime_error Если сокет не создаётся.
+     */
+    MetricsServer(const string& socketPath, const LiveMetrics& source) : path(socketPath), metrics(source) {
+        listener = listenUnixSocket(path, 16);
+        server = thread([this]() { serve(); });
+    }
+    ~MetricsServer() {
+        stopping = true;
+        server.join();
+        ::close(listener);
+        unlink(path.c_str());
+    }
+    MetricsServer(const MetricsServer&) = delete;
+    MetricsServer& operator=(const MetricsServer&) = delete;
 
-    string randomSpecies = getRandomSpecies(randomClimate);
+    /**
+     * @brief Показатели в текстовом формате Prometheus.
+     */
+    string render() const {
+        LiveMetrics::Sample sample = metrics.read();
+        ostringstream out;
+        auto metric = [&out](const char* name, const char* type, const char* help, auto value) {
+            out << "# HELP " << name << " " << help << "\n# TYPE " << name << " " << type << "\n" << name << " " << value << "\n";
+        };
+        metric("zoo_day", "gauge", "Текущий день зоопарка", sample.day);
+        metric("zoo_days_simulated_total", "counter", "Смоделировано дней", sample.daysSimulated);
+        metric("zoo_days_per_second", "gauge", "Средняя скорость моделирования, дней в секунду",
+            sample.seconds > 0 ? sample.daysSimulated / sample.seconds : 0.0);
+        metric("zoo_animals", "gauge", "Живых животных", sample.animals);
+        metric("zoo_infected_animals", "gauge", "Заражённых животных", sample.infected);
+        metric("zoo_money", "gauge", "Деньги зоопарка, монет", sample.money);
+        out << "# HELP zoo_tick_seconds Длительность одного дня (nextDay)\n# TYPE zoo_tick_seconds histogram\n";
+        uint64_t cumulative = 0;
+        for (int i = 0; i <= LiveMetrics::TICK_BUCKETS; ++i) {
+            cumulative += sample.ticks[i];
+            out << "zoo_tick_seconds_bucket{le=\"";
+            if (i < LiveMetrics::TICK_BUCKETS) out << LiveMetrics::TICK_BOUNDS[i];
+            else out << "+Inf";
+            out << "\"} " << cumulative << "\n";
+        }
+        out << "zoo_tick_seconds_sum " << sample.tickSum << "\nzoo_tick_seconds_count " << cumulative << "\n";
+#ifdef ZOO_COUNT_ALLOCATIONS
+        metric("zoo_allocations_total", "counter", "Вызовов operator new с начала программы",
+            allocationCount.load(memory_order_relaxed));
+        metric("zoo_allocated_bytes_total", "counter", "Байт, запрошенных через operator new",
+            allocatedBytes.load(memory_order_relaxed));
+#endif
+        return out.str();
+    }
 
-    Animal::Type randomType = (randomClimate == Animal::OCEAN) ? Animal::AQUATIC : Animal::LAND;
+private:
+    string path;                 ///< Путь к сокету
+    const LiveMetrics& metrics;  ///< Показатели прогона
+    int listener = -1;           ///< Слушающий сокет
+    atomic<bool> stopping{ false }; ///< Сервер останавливается
+    thread server;               ///< Поток сервера
+
+    void serve() {
+        Tracer::nameThread("metrics server");
+        while (!stopping) {
+            pollfd waiting = { listener, POLLIN, 0 };
+            if (poll(&waiting, 1, 100) <= 0) continue; // Раз в 100 мс проверяем остановку
+            int client = accept(listener, nullptr, nullptr);
+            if (client < 0) continue;
+            respond(client);
+            ::close(client);
+        }
+    }
+    void respond(int client) const {
+        // Запрос дочитывается, если он пришёл сразу; клиент без запроса тоже получает ответ
+        char request[4096];
+        pollfd readable = { client, POLLIN, 0 };
+        if (poll(&readable, 1, 100) > 0) recv(client, request, sizeof(request), 0);
+        string body = render();
+        string response = "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+            "Content-Length: " + to_string(body.size()) + "\r\nConnection: close\r\n\r\n" + body;
+        const int flags = noSigpipeFlags(client);
+        for (size_t sent = 0; sent < response.size();) {
+            ssize_t n = send(client, response.data() + sent, response.size() - sent, flags);
+            if (n <= 0) return;
+            sent += static_cast<size_t>(n);
+        }
+    }
+};
+#endif
 
-    return Animal("", randomSpecies, randomAge, randomWeight, randomClimate, isCarnivore, randomGender, randomType);
-}
 /**
- * @brief Изменяет имя животного в выбранном вольере.
- * @details Позволяет пользователю выбрать вольер, затем выбрать животное в этом вольере и изменить его имя.
- * @param zoo Ссылка на объект зоопарка.
+ * @brief Параметры пакетного (безынтерактивного) запуска.
  */
-void renameAnimal(Zoo& zoo) {
-    if (zoo.enclosures.empty()) {
-        cout << "У вас нет вольеров!\n";
-        return;
-    }
+struct HeadlessOptions {
+    uint64_t seed = 0;        ///< Зерно генераторов случайных чисел
+    int money = 10000;        ///< Начальный капитал
+    int days = 30;            ///< Сколько дней моделировать
+    string layoutPath;        ///< Файл с начальным устройством зоопарка (необязательно)
+    string name = "Пакетный зоопарк"; ///< Название зоопарка
+    int replicas = 0;         ///< Прогонов Монте-Карло; 0 — одиночный прогон
+    unsigned threads = 0;     ///< Потоков для прогонов; 0 — по числу ядер
+    bool checkTick = false;   ///< Сверять однопроходный день с многопроходным
+    bool legacySpread = false; ///< Прежнее распространение вируса (SpreadMode::LEGACY)
+    bool legacyAging = false;  ///< Прежние ежедневные броски старости (AgingMode::DAILY_ROLL)
+    string profileFormat;      ///< Вывод профиля дня: "table", "json" или пусто (нужна сборка с ZOO_PROFILE)
+    OutputSink::Mode output = OutputSink::SILENT; ///< Вывод сообщений дня одиночного прогона
+    LogLevel logLevel = LogLevel::TRACE;          ///< Наименьший выводимый уровень сообщений дня
+    string eventLogPath;      ///< Файл для журнала событий одиночного прогона (необязательно)
+    string printEventsPath;   ///< Файл журнала, который нужно только напечатать текстом
+    string restorePath;       ///< Снимок, с которого начинается прогон (вместо директора и --layout)
+    string snapshotPath;      ///< Куда записать снимок в конце прогона (необязательно)
+    int checkpointDays = 0;   ///< Записывать снимок каждые N дней; 0 — только в конце
+    string metricsPath;       ///< Файл показателей по дням: столбцовый или CSV (необязательно)
+    string printMetricsPath;  ///< Столбцовый файл показателей, который нужно только напечатать в CSV
+    string tracePath;         ///< Файл трассы Chrome trace JSON (необязательно)
+    string metricsSocketPath; ///< Unix-сокет сервера показателей одиночного прогона (необязательно)
+    string servePath;         ///< Unix-сокет сервера сеансов (необязательно)
+    size_t maxSessions = 4096;    ///< Наибольшее число одновременных сеансов сервера
+    size_t sessionLimit = 10000;  ///< Предел животных, вольеров и сотрудников зоопарка сеанса
+};
 
-    // Вывод списка вольеров
-    int index = 1;
-    for (auto& enc : zoo.enclosures) {
-        string climateName;
-        switch (enc.climate) {
-        case Animal::DESERT: climateName = "Пустыня"; break;
-        case Animal::FOREST: climateName = "Лес"; break;
-        case Animal::ARCTIC: climateName = "Арктика"; break;
-        case Animal::OCEAN: climateName = "Океан"; break;
+/**
+ * @brief Разбирает аргументы командной строки пакетного режима.
+ * @param argc Количество аргументов
+ * @param argv Аргументы
+ * @return Разобранные параметры.
+ * @throws runtime_error Если аргумент неизвестен или не содержит значения.
+ */
+HeadlessOptions parseHeadlessOptions(int argc, char* argv[]) {
+    HeadlessOptions options;
+    options.seed = static_cast<uint64_t>(time(0));
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg == "--headless") continue;
+        if (arg == "--check-tick") {
+            options.checkTick = true;
+            continue;
         }
-        cout << index << ". Климат: " << climateName
-            << ", Животных: " << enc.animals.size() << "/" << enc.capacity << "\n";
-        index++;
+        if (arg == "--legacy-spread") {
+            options.legacySpread = true;
+            continue;
+        }
+        if (arg == "--legacy-aging") {
+            options.legacyAging = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            throw runtime_error("Не указано значение для " + arg);
+        }
+        string value = argv[++i];
+        if (arg == "--seed") options.seed = stoull(value);
+        else if (arg == "--money") options.money = stoi(value);
+        else if (arg == "--days") options.days = stoi(value);
+        else if (arg == "--layout") options.layoutPath = value;
+        else if (arg == "--name") options.name = value;
+        else if (arg == "--event-log") options.eventLogPath = value;
+        else if (arg == "--print-events") options.printEventsPath = value;
+        else if (arg == "--restore") options.restorePath = value;
+        else if (arg == "--snapshot") options.snapshotPath = value;
+        else if (arg == "--checkpoint") options.checkpointDays = stoi(value);
+        else if (arg == "--metrics") options.metricsPath = value;
+        else if (arg == "--print-metrics") options.printMetricsPath = value;
+        else if (arg == "--trace") options.tracePath = value;
+        else if (arg == "--metrics-socket") {
+#ifdef _WIN32
+            throw runtime_error("Сервер показателей на Unix-сокете недоступен в Windows");
+#endif
+            options.metricsSocketPath = value;
+        }
+        else if (arg == "--serve") {
+#ifdef _WIN32
+            throw runtime_error("Сервер сеансов на Unix-сокете недоступен в Windows");
+#endif
+            options.servePath = value;
+        }
+        else if (arg == "--max-sessions") options.maxSessions = stoul(value);
+        else if (arg == "--session-limit") options.sessionLimit = stoul(value);
+        else if (arg == "--monte-carlo") options.replicas = stoi(value);
+        else if (arg == "--threads") options.threads = static_cast<unsigned>(stoul(value));
+        else if (arg == "--output") {
+            if (value == "console") options.output = OutputSink::CONSOLE;
+            else if (value == "buffered") options.output = OutputSink::BUFFERED;
+            else if (value == "silent") options.output = OutputSink::SILENT;
+            else throw runtime_error("Вывод сообщений: console, buffered или silent");
+        }
+        else if (arg == "--log-level") {
+            if (value == "trace") options.logLevel = LogLevel::TRACE;
+            else if (value == "info") options.logLevel = LogLevel::INFO;
+            else if (value == "notice") options.logLevel = LogLevel::NOTICE;
+            else throw runtime_error("Уровень сообщений: trace, info или notice");
+        }
+        else if (arg == "--profile") {
+#ifndef ZOO_PROFILE
+            throw runtime_error("Профилирование недоступно: соберите программу с -DZOO_PROFILE");
+#endif
+            if (value != "table" && value != "json") throw runtime_error("Формат профиля: table или json");
+            options.profileFormat = value;
+        }
+        else throw runtime_error("Неизвестный аргумент: " + arg);
     }
-
-    // Выбор вольера
-    int enclosureChoice = getIntegerInput("Введите номер вольера: ");
-    if (enclosureChoice <= 0 || enclosureChoice > zoo.enclosures.size()) {
-        cout << "Неверный номер вольера!\n";
-        return;
+    if (options.replicas < 0) throw runtime_error("Число прогонов не может быть отрицательным");
+    if (!options.restorePath.empty() && !options.layoutPath.empty()) {
+        throw runtime_error("--restore и --layout нельзя указывать вместе");
     }
+    if (options.checkpointDays < 0 || (options.checkpointDays > 0 && options.snapshotPath.empty())) {
+        throw runtime_error("--checkpoint требует положительного числа дней и --snapshot");
+    }
+    return options;
+}
 
-    auto encIt = zoo.enclosures.begin();
-    advance(encIt, enclosureChoice - 1);
+#ifdef ZOO_PROFILE
+/**
+ * @brief Печатает профиль дня в выбранном формате.
+ * @param profile Замеры
+ * @param format "table", "json" или пусто (ничего не печатать)
+ */
+void printProfile(const PhaseProfile& profile, const string& format) {
+    if (format == "table") profile.printTable(cout);
+    else if (format == "json") profile.printJson(cout);
+}
+#endif
 
-    // Проверка, есть ли животные в вольере
-    if (encIt->animals.empty()) {
-        cout << "В этом вольере нет животных!\n";
+/**
+ * @brief Строит начальный зоопарк пакетного режима: снимок либо директор и, если задан, файл устройства.
+ * @param zoo Пустой зоопарк
+ * @param options Параметры запуска
+ */
+void setupHeadlessZoo(Zoo& zoo, const HeadlessOptions& options) {
+    if (!options.restorePath.empty()) {
+        loadZooSnapshot(zoo, options.restorePath);
+        if (options.legacySpread) zoo.spreadMode = SpreadMode::LEGACY;
+        if (options.legacyAging) zoo.setAgingMode(AgingMode::DAILY_ROLL);
         return;
     }
-
-    // Вывод списка животных в выбранном вольере
-    cout << "Животные в вольере:\n";
-    index = 1;
-    for (auto& animal : encIt->animals) {
-        cout << index << ". " << animal.name << ", Вид: " << animal.species
-            << ", Возраст: " << animal.ageInDays << " дней\n";
-        index++;
+    if (options.legacySpread) zoo.spreadMode = SpreadMode::LEGACY;
+    if (options.legacyAging) zoo.setAgingMode(AgingMode::DAILY_ROLL);
+    zoo.hireEmployee("Егор Потрошила", "Директор", 50, 50);
+    if (!options.layoutPath.empty()) {
+        loadZooLayout(zoo, options.layoutPath);
     }
+}
 
-    // Выбор животного
-    int animalChoice = getIntegerInput("Введите номер животного для изменения имени: ");
-    if (animalChoice <= 0 || animalChoice > encIt->animals.size()) {
-        cout << "Неверный номер животного!\n";
-        return;
+/**
+ * @brief Запускает моделирование без меню: nextDay вызывается в цикле, сообщения дня не выводятся.
+ * @param options Параметры запуска
+ * @return Код завершения: 0 — зоопарк дожил до конца, 1 — банкротство.
+ */
+int runHeadless(const HeadlessOptions& options) {
+    Zoo zoo(options.name, options.money, options.seed);
+    auto loadStart = chrono::steady_clock::now();
+    setupHeadlessZoo(zoo, options);
+    double loadSeconds = chrono::duration<double>(chrono::steady_clock::now() - loadStart).count();
+    if (!options.eventLogPath.empty()) {
+        zoo.events.spillTo(options.eventLogPath);
+    }
+    unique_ptr<MetricsFile> metricsFile;
+    unique_ptr<MetricsRecorder> metrics;
+    if (!options.metricsPath.empty()) {
+        metricsFile = make_unique<MetricsFile>(options.metricsPath);
+        metrics = make_unique<MetricsRecorder>(*metricsFile, 0);
+        zoo.metrics = metrics.get();
+    }
+    LiveMetrics live;
+    LiveMetrics::Sample sample;
+#ifndef _WIN32
+    unique_ptr<MetricsServer> server;
+    if (!options.metricsSocketPath.empty()) {
+        server = make_unique<MetricsServer>(options.metricsSocketPath, live);
     }
+#endif
+    bool publish = !options.metricsSocketPath.empty();
+    auto publishSample = [&](double seconds) {
+        sample.day = zoo.day;
+        sample.animals = zoo.animalCounts.animals;
+        sample.infected = zoo.animalCounts.infected;
+        sample.money = zoo.money;
+        sample.seconds = seconds;
+        live.publish(sample);
+    };
+    if (publish) publishSample(0);
+    int startAnimals = zoo.getTotalAnimals();
+
+#ifdef ZOO_PROFILE
+    threadProfile = PhaseProfile(); // Замеряем только моделирование, без загрузки
+#endif
+    auto start = chrono::steady_clock::now();
+    int simulated = 0;
+    {
+        OutputSink sink(options.output, options.logLevel); // По умолчанию сообщения дня никто не читает
+        SinkScope scope(sink);
+        while (simulated < options.days && !zoo.isBankrupt()) {
+            auto dayStart = publish ? chrono::steady_clock::now() : chrono::steady_clock::time_point();
+            if (options.checkTick) {
+                // Тот же день многопроходным обходом на копии; состояния должны совпасть
+                Zoo reference(zoo);
+                reference.tickMode = Zoo::TickMode::MULTI_PASS;
+                {
+                    OutputSink silent(OutputSink::SILENT);
+                    SinkScope silentScope(silent);
+                    reference.nextDay();
+                }
+                zoo.nextDay();
+                if (zoo.stateHash() != reference.stateHash()) {
+                    throw runtime_error("День " + to_string(reference.day - 1) + ": однопроходный обход разошёлся с многопроходным");
+                }
+                if (!zoo.countsConsistent() || !reference.countsConsistent()) {
+                    throw runtime_error("День " + to_string(reference.day - 1) + ": счётчики животных разошлись с пересчётом");
+                }
+            }
+            else {
+                zoo.nextDay();
+            }
+            simulated++;
+            if (publish) {
+                auto dayEnd = chrono::steady_clock::now();
+                sample.daysSimulated = simulated;
+                sample.addTick(chrono::duration<double>(dayEnd - dayStart).count());
+                publishSample(chrono::duration<double>(dayEnd - start).count());
+            }
+            if (options.checkpointDays > 0 && simulated % options.checkpointDays == 0) {
+                saveZooSnapshot(zoo, options.snapshotPath);
+            }
+        }
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
 
-    auto animalIt = encIt->animals.begin();
-    advance(animalIt, animalChoice - 1);
+    int infected = zoo.animalCounts.infected;
 
-    // Запрос нового имени
-    cout << "Текущее имя: " << animalIt->name << "\n";
-    cout << "Введите новое имя: ";
-    string newName;
-    getline(cin, newName);
+    if (!options.snapshotPath.empty()) {
+        saveZooSnapshot(zoo, options.snapshotPath);
+    }
 
-    // Изменение имени
-    animalIt->name = newName;
-    cout << "Имя успешно изменено на \"" << newName << "\".\n";
+    cout << "=== Итоги: " << zoo.name << " ===\n";
+    cout << "Зерно: " << zoo.seed << "\n";
+    cout << "Дней смоделировано: " << simulated << " из " << options.days << "\n";
+    cout << "Итог: " << (zoo.isBankrupt() ? "банкротство" : "зоопарк работает") << "\n";
+    cout << "Деньги: " << zoo.money << " монет\n";
+    cout << "Еда: " << zoo.food << " кг\n";
+    cout << "Популярность: " << zoo.popularity << "\n";
+    cout << "Животных: " << zoo.getTotalAnimals() << " (в начале " << startAnimals << ", заражено " << infected << ")\n";
+    cout << "Погибло: от старости " << zoo.deaths.oldAge << ", от вируса " << zoo.deaths.virus
+        << ", от голода " << zoo.deaths.starvation << "\n";
+    cout << "Вольеров: " << zoo.enclosures.size() << "\n";
+    cout << "Работников: " << zoo.employees.size() << "\n";
+    if (zoo.getTotalAnimals() > 0) cout << "Память на животное: " << zoo.bytesPerAnimal() << " байт\n";
+    if (!options.eventLogPath.empty()) {
+        zoo.events.close();
+        cout << "Журнал событий: " << zoo.events.recorded() << " записей в " << options.eventLogPath << "\n";
+    }
+    if (metrics) {
+        metrics->flush();
+        cout << "Показатели: " << simulated << " дней в " << options.metricsPath << "\n";
+    }
+    if (options.checkTick) {
+        cout << "Сверка с многопроходным обходом и счётчиками: совпадает\n";
+    }
+    if (!options.restorePath.empty()) {
+        cout << "Снимок загружен из " << options.restorePath << " за " << loadSeconds * 1000 << " мс\n";
+    }
+    if (!options.snapshotPath.empty()) {
+        cout << "Снимок записан в " << options.snapshotPath << "\n";
+    }
+    cout << "Время: " << seconds * 1000 << " мс (" << (seconds > 0 ? simulated / seconds : 0) << " дней/с)\n";
+#ifdef ZOO_PROFILE
+    printProfile(threadProfile, options.profileFormat);
+#endif
+    return zoo.isBankrupt() ? 1 : 0;
 }
 
 /**
- * @brief Управляет животными зоопарка.
- * @param zoo Ссылка на объект зоопарка
+ * @brief Итог одного прогона Монте-Карло.
  */
-void manageAnimals(Zoo& zoo) {
-    cout << "\n--- Управление животными ---\n";
-    cout << "1. Купить готовое животное\n";
-    cout << "2. Продать животное\n";
-    cout << "3. Просмотреть животных\n";
-    cout << "4. Лечение жвиотных\n";
-    cout << "5. Обновить список животных (цена 150 монет)\n";
-    cout << "6. Размножить животных\n";
-    cout << "7. Изменить имя животного\n";
-    cout << "0. Назад\n";
-
-    int choice = getIntegerInput("Выберите действие: ");
-    switch (choice) {
-    case 1: { // Покупка готового животного
-        cout << "\n--- Покупка готового животного ---\n";
-
-        if (zoo.animalMarket.empty()) {
-            cout << "На рынке нет доступных животных!\n";
-            break;
-        }
+struct ReplicaResult {
+    bool bankrupt = false;     ///< Прогон закончился банкротством
+    int days = 0;              ///< Сколько дней смоделировано
+    int money = 0;             ///< Деньги в конце
+    int popularity = 0;        ///< Популярность в конце
+    int animals = 0;           ///< Животных в конце
+    Zoo::DeathCounts deaths;   ///< Погибшие за прогон
+#ifdef ZOO_PROFILE
+    PhaseProfile profile;      ///< Замеры фаз дня за прогон
+#endif
+};
 
-        // Ограничение на покупку после 10 - го дня
-        if (zoo.day > 10) {
-            cout << "После 10-го дня можно купить только одно животное в день!\n";
-            if (zoo.animalsBoughtToday >= 1) {
-                cout << "Вы уже купили животное сегодня.\n";
-                break;
+/**
+ * @brief Прогоняет копии начального зоопарка с разными зёрнами на пуле потоков.
+ * @details Прогон i — копия start с зерном baseSeed + i, поэтому результат
+ * не зависит от числа потоков и порядка выполнения.
+ * @param start Начальный зоопарк; во время прогонов только читается
+ * @param replicas Количество прогонов
+ * @param days Дней в каждом прогоне
+ * @param baseSeed Зерно первого прогона
+ * @param pool Пул потоков
+ * @param metrics Файл показателей по дням или nullptr; прогон i пишет в него блоки с номером i
+ * @return Итоги прогонов в порядке номеров.
+ */
+vector<ReplicaResult> runMonteCarlo(const Zoo& start, int replicas, int days, uint64_t baseSeed, WorkStealingPool& pool,
+    MetricsFile* metrics = nullptr) {
+    vector<ReplicaResult> results(replicas);
+    for (int i = 0; i < replicas; ++i) {
+        pool.submit([&start, &results, i, days, baseSeed, metrics]() {
+            ZOO_TRACE_SCOPE("replica", "replica", i);
+            OutputSink silent(OutputSink::SILENT);
+            SinkScope scope(silent);
+            unique_ptr<MetricsRecorder> recorder;
+            if (metrics) {
+                // Короткие прогоны не держат полный блок на каждый поток
+                recorder = make_unique<MetricsRecorder>(*metrics, static_cast<uint32_t>(i),
+                    min(static_cast<size_t>(max(days, 0)), MetricsRecorder::DEFAULT_ROWS));
             }
-        }
-
-        // Выводим список животных
-        cout << "Доступные животные:\n";
-        for (int i = 0; i < zoo.animalMarket.size(); ++i) {
-            Animal& animal = zoo.animalMarket[i];
-            string climateName;
-            switch (animal.climate) {
-            case Animal::DESERT: climateName = "Пустыня"; break;
-            case Animal::FOREST: climateName = "Лес"; break;
-            case Animal::ARCTIC: climateName = "Арктика"; break;
-            case Animal::OCEAN: climateName = "Океан"; break;
+            Zoo zoo(start);
+            zoo.reseed(baseSeed + static_cast<uint64_t>(i));
+            zoo.metrics = recorder.get();
+            ReplicaResult result;
+#ifdef ZOO_PROFILE
+            threadProfile = PhaseProfile();
+#endif
+            while (result.days < days && !zoo.isBankrupt()) {
+                zoo.nextDay();
+                result.days++;
             }
-            cout << i + 1 << ". Вид: " << animal.species // Используем поле species
-                << ", Климат: " << climateName
-                << ", Возраст: " << animal.ageInDays << " дней"
-                << ", Вес: " << animal.weight << " кг"
-                << ", Пол: " << (animal.gender == 'M' ? "М" : "Ж")
-                << ", Тип: " << (animal.isCarnivore ? "Хищник" : "Травоядное")
-                << ", Тип животного: " << (animal.isAquatic() ? "Вода" : "Земля")
-                << ", Цена: " << animal.calculatePrice() << "\n";
-        }
-        // Выбор животного
-        int choice = getIntegerInput("Введите номер животного для покупки: ");
-        if (choice <= 0 || choice > zoo.animalMarket.size()) {
-            cout << "Неверный номер!\n";
-            break;
-        }
-
-        Animal selectedAnimal = zoo.animalMarket[choice - 1];
-        int price = selectedAnimal.calculatePrice();
-
-        cout << "Итоговая цена животного: " << price << " монет\n";
-        cout << "Хотите купить это животное?\n";
-        cout << "1. Да\n2. Нет\n";
-        int confirm = getIntegerInput("Ваш выбор: ");
-
-        if (confirm != 1) {
-            cout << "Покупка отменена.\n";
-            break;
-        }
+            result.bankrupt = zoo.isBankrupt();
+            result.money = zoo.money;
+            result.popularity = zoo.popularity;
+            result.animals = zoo.getTotalAnimals();
+            result.deaths = zoo.deaths;
+#ifdef ZOO_PROFILE
+            result.profile = threadProfile;
+#endif
+            results[i] = result;
+        });
+    }
+    pool.wait();
+    return results;
+}
 
-        if (zoo.money < price) {
-            cout << "Недостаточно средств для покупки!\n";
-            break;
-        }
+/**
+ * @brief Процентиль по методу ближайшего ранга.
+ * @param sorted Отсортированные значения (не пустые)
+ * @param percent Процентиль от 0 до 100
+ */
+int percentile(const vector<int>& sorted, int percent) {
+    size_t rank = (sorted.size() * percent + 99) / 100;
+    return sorted[rank == 0 ? 0 : rank - 1];
+}
 
-        // Запрос имени для животного
-        string name;
-        cout << "Введите имя для животного: ";
-        getline(cin, name);
-        selectedAnimal.name = name;
+/**
+ * @brief Итоги прогноза одного сценария по развилкам зоопарка.
+ */
+struct Forecast {
+    vector<ReplicaResult> branches; ///< Итоги развилок в порядке номеров
+    size_t sharedBytes = 0;         ///< Сколько данных развилки в среднем ещё разделяли с зоопарком в конце
+    double seconds = 0;             ///< Время прогноза
+};
 
-        // Фильтрация вольеров по климату
-        vector<Enclosure*> suitableEnclosures;
-        for (auto& enc : zoo.enclosures) {
-            if (enc.climate == selectedAnimal.climate && enc.canAddAnimal(selectedAnimal)) {
-                suitableEnclosures.push_back(&enc);
+/**
+ * @brief Прогнозирует будущее зоопарка по развилкам (Zoo::fork) на пуле потоков.
+ * @details Развилка i получает номер i + 1, поэтому прогнозы разных сценариев одного зоопарка
+ * идут на одних и тех же зёрнах и различаются только действием. Сообщения дня не выводятся.
+ * @param live Текущий зоопарк; во время прогноза только читается
+ * @param branches Количество развилок
+ * @param days Дней в каждой развилке
+ * @param action Действие игрока, выполняемое в каждой развилке перед первым днём (может быть пустым)
+ * @param pool Пул потоков
+ */
+Forecast forecastZoo(const Zoo& live, int branches, int days, const function<void(Zoo&)>& action, WorkStealingPool& pool) {
+    Forecast forecast;
+    forecast.branches.resize(branches);
+    vector<size_t> shared(branches);
+    auto begin = chrono::steady_clock::now();
+    for (int i = 0; i < branches; ++i) {
+        pool.submit([&live, &forecast, &shared, &action, i, days]() {
+            ZOO_TRACE_SCOPE("forecast", "branch", i + 1);
+            OutputSink silent(OutputSink::SILENT);
+            SinkScope scope(silent);
+            unique_ptr<Zoo> zoo = live.fork(static_cast<uint32_t>(i) + 1);
+            if (action) action(*zoo);
+            ReplicaResult result;
+            while (result.days < days && !zoo->isBankrupt()) {
+                zoo->nextDay();
+                result.days++;
             }
-        }
-
-        if (suitableEnclosures.empty()) {
-            cout << "Ошибка: Нет подходящего вольера!\n";
-            break;
-        }
+            result.bankrupt = zoo->isBankrupt();
+            result.money = zoo->money;
+            result.popularity = zoo->popularity;
+            result.animals = zoo->getTotalAnimals();
+            result.deaths = zoo->deaths;
+            forecast.branches[i] = result;
+            shared[i] = zoo->sharedBytes();
+        });
+    }
+    pool.wait();
+    forecast.seconds = chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+    for (size_t bytes : shared) forecast.sharedBytes += bytes;
+    if (branches > 0) forecast.sharedBytes /= branches;
+    return forecast;
+}
 
-        // Вывод подходящих вольеров
-        cout << "\nВыберите вольер для размещения животного:\n";
-        for (int i = 0; i < suitableEnclosures.size(); ++i) {
-            Enclosure* enc = suitableEnclosures[i];
-            cout << i + 1 << ". Климат: " << (enc->climate == Animal::DESERT ? "Пустыня" :
-                enc->climate == Animal::FOREST ? "Лес" :
-                enc->climate == Animal::ARCTIC ? "Арктика" : "Океан")
-                << ", Животных: " << enc->animals.size() << "/" << enc->capacity << "\n";
+/**
+ * @brief Печатает прогноз на 10 дней: как есть и, если задано действие, после него.
+ * @param zoo Зоопарк
+ * @param title Название действия для сводки
+ * @param action Действие игрока или пустая функция
+ */
+void showForecast(const Zoo& zoo, const string& title, const function<void(Zoo&)>& action) {
+    const int FORECAST_DAYS = 10;
+    const int FORECAST_BRANCHES = 32;
+    WorkStealingPool pool(0);
+
+    auto printForecast = [](const string& scenario, const Forecast& forecast) {
+        int bankrupt = 0;
+        vector<int> money, animals;
+        for (const ReplicaResult& r : forecast.branches) {
+            if (r.bankrupt) bankrupt++;
+            money.push_back(r.money);
+            animals.push_back(r.animals);
         }
+        sort(money.begin(), money.end());
+        sort(animals.begin(), animals.end());
+        cout << scenario << ": банкротств " << bankrupt << " из " << forecast.branches.size()
+            << ", деньги p10=" << percentile(money, 10) << " p50=" << percentile(money, 50)
+            << " p90=" << percentile(money, 90) << ", животных (медиана) " << percentile(animals, 50) << "\n";
+    };
+
+    cout << "\n--- Прогноз на " << FORECAST_DAYS << " дней, вариантов: " << FORECAST_BRANCHES << " ---\n";
+    Forecast base = forecastZoo(zoo, FORECAST_BRANCHES, FORECAST_DAYS, nullptr, pool);
+    printForecast("Как есть", base);
+    double seconds = base.seconds;
+    if (action) {
+        Forecast changed = forecastZoo(zoo, FORECAST_BRANCHES, FORECAST_DAYS, action, pool);
+        printForecast(title, changed);
+        seconds += changed.seconds;
+    }
+    cout << "Варианты разделяли с зоопарком в среднем " << base.sharedBytes / 1024 << " КБ данных животных; "
+        << "расчёт занял " << seconds * 1000 << " мс\n";
+}
 
-        int enclosureChoice = getIntegerInput("Введите номер вольера: ");
-        if (enclosureChoice <= 0 || enclosureChoice > suitableEnclosures.size()) {
-            cout << "Неверный номер вольера!\n";
-            break;
+/**
+ * @brief Запускает серию прогонов Монте-Карло и печатает сводку.
+ * @param options Параметры запуска
+ * @return Код завершения: 0.
+ */
+int runMonteCarloHeadless(const HeadlessOptions& options) {
+    Zoo start(options.name, options.money, options.seed);
+    setupHeadlessZoo(start, options); // Все виды попадают в таблицу до запуска потоков
+
+    WorkStealingPool pool(options.threads);
+    unique_ptr<MetricsFile> metrics;
+    if (!options.metricsPath.empty()) metrics = make_unique<MetricsFile>(options.metricsPath);
+    auto begin = chrono::steady_clock::now();
+    vector<ReplicaResult> results = runMonteCarlo(start, options.replicas, options.days, options.seed, pool, metrics.get());
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+
+    int bankrupt = 0;
+    long long oldAge = 0, virus = 0, starvation = 0, totalDays = 0;
+    vector<int> money, popularity;
+    for (const ReplicaResult& r : results) {
+        if (r.bankrupt) bankrupt++;
+        totalDays += r.days;
+        oldAge += r.deaths.oldAge;
+        virus += r.deaths.virus;
+        starvation += r.deaths.starvation;
+        money.push_back(r.money);
+        popularity.push_back(r.popularity);
+    }
+    sort(money.begin(), money.end());
+    sort(popularity.begin(), popularity.end());
+
+    const int PERCENTILES[] = { 5, 25, 50, 75, 95 };
+    auto printPercentiles = [&](const string& title, const vector<int>& values) {
+        cout << title << ":";
+        for (int p : PERCENTILES) {
+            cout << " p" << p << "=" << percentile(values, p);
         }
+        cout << "\n";
+    };
+
+    int n = options.replicas;
+    cout << "=== Монте-Карло: " << start.name << " ===\n";
+    cout << "Прогонов: " << n << ", дней в прогоне: " << options.days << ", потоков: " << pool.threadCount() << "\n";
+    cout << "Зёрна: " << options.seed << " .. " << options.seed + n - 1 << "\n";
+    if (n == 0) return 0;
+    cout << "Банкротств: " << bankrupt << " (" << 100.0 * bankrupt / n << "%)\n";
+    printPercentiles("Деньги", money);
+    printPercentiles("Популярность", popularity);
+    if (metrics) cout << "Показатели по дням: " << options.metricsPath << " (столбец run — номер прогона)\n";
+    cout << "Погибло всего: от старости " << oldAge << ", от вируса " << virus << ", от голода " << starvation << "\n";
+    cout << "Погибло в среднем за прогон: от старости " << static_cast<double>(oldAge) / n
+        << ", от вируса " << static_cast<double>(virus) / n << ", от голода " << static_cast<double>(starvation) / n << "\n";
+    cout << "Время: " << seconds * 1000 << " мс (" << (seconds > 0 ? n / seconds : 0) << " прогонов/с, "
+        << (seconds > 0 ? totalDays / seconds : 0) << " дней/с)\n";
+#ifdef ZOO_PROFILE
+    PhaseProfile merged;
+    for (const ReplicaResult& r : results) merged += r.profile;
+    printProfile(merged, options.profileFormat); // Время фаз суммируется по всем потокам
+#endif
+    return 0;
+}
 
-        Enclosure* selectedEnclosure = suitableEnclosures[enclosureChoice - 1];
-        selectedEnclosure->addAnimal(selectedAnimal);
-        zoo.money -= price;
-
-        cout << "Животное \"" << selectedAnimal.name << "\" успешно добавлено в вольер!\n";
+/**
+ * @brief Читает строковый аргумент журнала: остаток строки после одного пробела.
+ */
+string readJournalString(istringstream& in) {
+    if (in.peek() == ' ') in.get();
+    string text;
+    getline(in, text);
+    return text;
+}
 
-        // Удаляем купленное животное из пула
-        zoo.animalMarket.erase(zoo.animalMarket.begin() + choice - 1);
+/**
+ * @brief Итог действия, выполненного applyZooAction.
+ */
+enum class ActionResult {
+    DONE,    ///< Действие выполнено
+    FAILED,  ///< Аргументы не разобрались или игра отказала
+    UNKNOWN  ///< Такого действия нет
+};
 
-        break;
+/**
+ * @brief Выполняет простое действие журнала у зоопарка теми же методами, что и меню.
+ * @details Разбирает build, upgrade, buy, sell, cure, hire, fire, food, advertise, market
+ * и rename в формате ActionJournal; действия со своими правилами (zoo, day, breed)
+ * обрабатывает вызывающий: воспроизведение журнала и сервер сеансов.
+ * @param zoo Зоопарк
+ * @param action Имя действия
+ * @param in Аргументы действия
+ * @return Итог действия.
+ */
+ActionResult applyZooAction(Zoo& zoo, const string& action, istringstream& in) {
+    bool done;
+    if (action == "build") {
+        int climate, capacity;
+        done = in >> climate >> capacity && zoo.buildEnclosure(climate, capacity);
     }
-    case 2: { // Продажа животного
-        cout << "\n--- Продажа животных ---\n";
-        if (zoo.enclosures.empty()) {
-            cout << "У вас нет вольеров!\n";
-            break;
-        }
+    else if (action == "upgrade") {
+        size_t enclosure;
+        done = in >> enclosure && zoo.upgradeEnclosure(enclosure);
+    }
+    else if (action == "buy") {
+        size_t marketIndex, enclosure;
+        done = in >> marketIndex >> enclosure && zoo.buyAnimal(marketIndex, enclosure, readJournalString(in)) != NO_ANIMAL;
+    }
+    else if (action == "sell") {
+        size_t enclosure, row;
+        done = in >> enclosure >> row && zoo.sellAnimal(enclosure, row) >= 0;
+    }
+    else if (action == "cure") {
+        AnimalId id;
+        done = in >> id && zoo.treatAnimal(id);
+    }
+    else if (action == "hire") {
+        int position;
+        done = in >> position && zoo.hireStaff(position, readJournalString(in));
+    }
+    else if (action == "fire") {
+        size_t position;
+        done = in >> position && zoo.dismissEmployee(position);
+    }
+    else if (action == "food") {
+        int amount;
+        done = in >> amount && zoo.buyFood(amount);
+    }
+    else if (action == "advertise") {
+        int cost;
+        done = in >> cost && zoo.advertise(cost) >= 0;
+    }
+    else if (action == "market") {
+        done = zoo.refreshAnimalMarket(zoo.day);
+    }
+    else if (action == "rename") {
+        AnimalId id;
+        done = in >> id && zoo.setAnimalName(id, readJournalString(in));
+    }
+    else {
+        return ActionResult::UNKNOWN;
+    }
+    return done ? ActionResult::DONE : ActionResult::FAILED;
+}
 
-        // Вывод списка вольеров
-        int index = 1;
-        for (auto& enc : zoo.enclosures) {
-            string climateName;
-            switch (enc.climate) {
-            case Animal::DESERT: climateName = "Пустыня"; break;
-            case Animal::FOREST: climateName = "Лес"; break;
-            case Animal::ARCTIC: climateName = "Арктика"; break;
-            case Animal::OCEAN: climateName = "Океан"; break;
+/**
+ * @brief Воспроизводит журнал действий без меню и сообщений, с наибольшей скоростью.
+ * @details Действия вызываются напрямую у Zoo теми же методами, что и из меню; после
+ * каждого nextDay хеш состояния сверяется с записанным в строке day.
+ * @param path Путь к журналу (см. ActionJournal)
+ * @return 0, если все дни совпали с журналом.
+ * @throws runtime_error Если журнал повреждён, действие не выполнилось или состояние разошлось.
+ */
+int runReplay(const string& path) {
+    ifstream file(path);
+    if (!file) {
+        throw runtime_error("Не удалось открыть журнал действий: " + path);
+    }
+    OutputSink silent(OutputSink::SILENT);
+    SinkScope scope(silent);
+
+    unique_ptr<Zoo> zoo;
+    int actions = 0, days = 0;
+    string line;
+    int lineNumber = 0;
+    auto start = chrono::steady_clock::now();
+    while (getline(file, line)) {
+        lineNumber++;
+        istringstream in(line);
+        string action;
+        if (!(in >> action) || action[0] == '#') continue;
+
+        string where = path + ":" + to_string(lineNumber) + ": ";
+        if (action == "ZOOJRN") {
+            int version = 0;
+            if (!(in >> version) || version != ActionJournal::VERSION) {
+                throw runtime_error(where + "версия журнала не поддерживается");
             }
-            cout << index << ". Климат: " << climateName
-                << ", Животных: " << enc.animals.size() << "/" << enc.capacity << "\n";
-            index++;
-        }
-
-        // Выбор вольера
-        int enclosureChoice = getIntegerInput("Введите номер вольера: ");
-        if (enclosureChoice <= 0 || enclosureChoice > zoo.enclosures.size()) {
-            cout << "Неверный номер вольера!\n";
-            break;
-        }
-
-        auto encIt = zoo.enclosures.begin();
-        advance(encIt, enclosureChoice - 1);
-
-        // Проверка, есть ли животные в вольере
-        if (encIt->animals.empty()) {
-            cout << "В этом вольере нет животных!\n";
-            break;
+            continue;
         }
-
-        // Вывод списка животных в выбранном вольере
-        cout << "\nЖивотные в вольере:\n";
-        index = 1;
-        for (auto& animal : encIt->animals) {
-            cout << index << ". " << animal.name << ", Возраст: " << animal.ageInDays
-                << ", Вес: " << animal.weight << ", Цена: " << animal.calculatePrice() << "\n";
-            index++;
+        if (action == "zoo") {
+            uint64_t seed;
+            int money;
+            if (!(in >> seed >> money)) throw runtime_error(where + "ожидается 'zoo <зерно> <капитал> <название>'");
+            zoo = make_unique<Zoo>(readJournalString(in), money, seed);
+            zoo->hireEmployee("Егор Потрошила", "Директор", 50, 50);
+            continue;
         }
-
-        // Выбор животного
-        int animalChoice = getIntegerInput("Введите номер животного для продажи: ");
-        if (animalChoice <= 0 || animalChoice > encIt->animals.size()) {
-            cout << "Неверный номер животного!\n";
-            break;
+        if (!zoo) throw runtime_error(where + "действие до строки zoo");
+
+        bool done = true;
+        if (action == "day") {
+            uint64_t expected;
+            if (!(in >> expected)) throw runtime_error(where + "ожидается 'day <хеш>'");
+            zoo->nextDay();
+            days++;
+            if (zoo->stateHash() != expected) {
+                throw runtime_error(where + "день " + to_string(zoo->day - 1) + ": состояние разошлось с журналом");
+            }
         }
-
-        auto animalIt = encIt->animals.begin();
-        advance(animalIt, animalChoice - 1);
-
-        // Расчет цены продажи
-        int price = animalIt->calculatePrice();
-        int sellPrice = price * 0.8; // 80% от цены
-
-        // Вывод информации о продаже
-        cout << "Животное \"" << animalIt->name << "\" можно продать за " << sellPrice << " монет.\n";
-        cout << "Вы уверены, что хотите продать это животное?\n";
-        cout << "1. Да\n2. Нет\n";
-        int confirm = getIntegerInput("Ваш выбор: ");
-
-        // Подтверждение продажи
-        if (confirm != 1) {
-            cout << "Продажа отменена.\n";
-            break;
+        else if (action == "breed") {
+            size_t enclosure, parent1, parent2, count;
+            done = in >> enclosure >> parent1 >> parent2 >> count && enclosure < zoo->enclosures.size()
+                && zoo->enclosures[enclosure].canBreed(parent1, parent2);
+            vector<string> names;
+            while (done && names.size() < count && getline(file, line)) {
+                lineNumber++;
+                istringstream nameLine(line);
+                string tag;
+                if (!(nameLine >> tag) || tag != "name") throw runtime_error(path + ":" + to_string(lineNumber) + ": ожидается 'name <имя>'");
+                names.push_back(readJournalString(nameLine));
+            }
+            if (done) {
+                size_t next = 0;
+                vector<string> born = zoo->enclosures[enclosure].breedPair(parent1, parent2, [&](SpeciesId) {
+                    return next < names.size() ? names[next++] : string();
+                });
+                done = born == names;
+            }
+        }
+        else {
+            ActionResult result = applyZooAction(*zoo, action, in);
+            if (result == ActionResult::UNKNOWN) throw runtime_error(where + "неизвестное действие '" + action + "'");
+            done = result == ActionResult::DONE;
         }
+        if (!done) throw runtime_error(where + "действие '" + action + "' не выполнилось: журнал разошёлся с игрой");
+        actions++;
+    }
+    if (!zoo) throw runtime_error("В журнале нет строки zoo: " + path);
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    cout << "=== Воспроизведение: " << zoo->name << " ===\n";
+    cout << "Зерно: " << zoo->seed << "\n";
+    cout << "Действий: " << actions << ", из них дней: " << days << "\n";
+    cout << "Сверка хеша состояния после каждого дня: совпадает\n";
+    cout << "Итог: день " << zoo->day << ", деньги " << zoo->money << ", животных " << zoo->getTotalAnimals() << "\n";
+    cout << "Время: " << seconds * 1000 << " мс (" << (seconds > 0 ? actions / seconds : 0) << " действий/с)\n";
+    return 0;
+}
 
-        // Сохраняем имя животного перед удалением
-        string animalName = animalIt->name;
+#ifndef _WIN32
+/// Запрошена остановка сервера сеансов (SIGINT, SIGTERM)
+volatile sig_atomic_t sessionServerStop = 0;
 
-        // Удаление животного и добавление денег
-        zoo.money += sellPrice;
-        encIt->animals.erase(animalIt);
+/**
+ * @brief Сервер сеансов игры на Unix-сокете (--serve).
+ * @details Каждое соединение — отдельный сеанс со своим зоопарком. Клиент шлёт текстовые
+ * команды по одной в строке и на каждую получает ответ "ok ..." или "error ...". Действия
+ * записываются как в журнале действий (ActionJournal) и выполняются теми же методами Zoo,
+ * что и меню. Один поток ввода-вывода опрашивает все сокеты через poll и складывает строки
+ * в очереди сеансов, а команды выполняются на пуле потоков: задача сеанса выполняет
+ * до BATCH команд подряд, поэтому сеанс никогда не выполняется двумя потоками сразу,
+ * а остальные сеансы не ждут его долго.
+ *
+ * Память сеанса ограничена: длина команды, очередь команд, буфер ответов, журнал событий
+ * и число животных, вольеров и сотрудников имеют пределы. Пока буфер ответов полон или
+ * очередь длинна, сокет клиента не читается.
+ */
+class SessionServer {
+public:
+    static constexpr size_t MAX_LINE = 4096;         ///< Наибольшая длина команды, байт
+    static constexpr size_t MAX_PENDING = 64;        ///< Команд в очереди, после которых сокет не читается
+    static constexpr size_t MAX_OUTPUT = 64 * 1024;  ///< Байт неотправленных ответов, после которых команды ждут
+    static constexpr int BATCH = 32;                 ///< Команд за одну задачу пула
+    static constexpr int MAX_DAYS = 365;             ///< Наибольшее число дней в команде day
+    static constexpr size_t EVENT_CAPACITY = 256;    ///< Ёмкость журнала событий зоопарка сеанса
 
-        // Вывод сообщения об успешной продаже
-        cout << "Животное \"" << animalName << "\" продано за " << sellPrice << " монет.\n";
-        break;
+    /**
+     * @brief Открывает сокет и запускает пул потоков.
+     * @param socketPath Путь к сокету; существующий файл заменяется
+     * @param threads Потоков пула; 0 — по числу ядер
+     * @param maxSessions Наибольшее число одновременных сеансов
+     * @param sessionLimit Наибольшее число животных, вольеров и сотрудников в зоопарке сеанса
+     * @throws runtime_error Если сокет не создаётся.
+     */
+    SessionServer(const string& socketPath, unsigned threads, size_t maxSessions, size_t sessionLimit)
+        : path(socketPath), maxSessions(maxSessions), sessionLimit(sessionLimit), pool(threads) {
+        // Каждому сеансу нужен дескриптор: поднимаем мягкий предел открытых файлов до жёсткого
+        rlimit files;
+        if (getrlimit(RLIMIT_NOFILE, &files) == 0 && files.rlim_cur < files.rlim_max) {
+            files.rlim_cur = files.rlim_max;
+            setrlimit(RLIMIT_NOFILE, &files);
+        }
+        listener = listenUnixSocket(path, 1024);
+        int ends[2];
+        if (pipe(ends) != 0) {
+            ::close(listener);
+            throw runtime_error(string("Не удалось создать канал сервера: ") + strerror(errno));
+        }
+        wakeRead = ends[0];
+        wakeWrite = ends[1];
+        for (int fd : { listener, wakeRead, wakeWrite }) fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
     }
-    case 3: { // Просмотреть животных
-        cout << "Список животных:\n";
-        for (auto& enc : zoo.enclosures) {
-            for (auto& animal : enc.animals) {
-                string climateName;
-                switch (animal.climate) {
-                case Animal::DESERT: climateName = "Пустыня"; break;
-                case Animal::FOREST: climateName = "Лес"; break;
-                case Animal::ARCTIC: climateName = "Арктика"; break;
-                case Animal::OCEAN: climateName = "Океан"; break;
+    ~SessionServer() {
+        pool.wait(); // Задачи сеансов ссылаются на сеансы и канал пробуждения
+        for (auto& session : sessions) ::close(session->socket);
+        ::close(listener);
+        ::close(wakeRead);
+        ::close(wakeWrite);
+        unlink(path.c_str());
+    }
+    SessionServer(const SessionServer&) = delete;
+    SessionServer& operator=(const SessionServer&) = delete;
+
+    /**
+     * @brief Обслуживает клиентов, пока не установлен sessionServerStop.
+     * @throws runtime_error Если poll завершился ошибкой.
+     */
+    void run() {
+        Tracer::nameThread("session server");
+        vector<pollfd> watched;
+        char buffer[16 * 1024];
+        while (!sessionServerStop) {
+            watched.clear();
+            watched.push_back({ listener, POLLIN, 0 });
+            watched.push_back({ wakeRead, POLLIN, 0 });
+            for (auto& session : sessions) {
+                short events = 0;
+                {
+                    lock_guard<mutex> guard(session->lock);
+                    if (!session->readClosed && !session->quit && session->commands.size() < MAX_PENDING
+                        && session->output.size() < MAX_OUTPUT) events |= POLLIN;
+                    if (!session->output.empty()) events |= POLLOUT;
                 }
-                cout << "- " << animal.name << ", "
-                    << "Вид: " << animal.species << ", "
-                    << animal.ageInDays << " дней, "
-                    << animal.weight << " кг, "
-                    << (animal.isCarnivore ? "Хищник" : "Травоядное") << ", "
-                    << (animal.isAquatic() ? "Водоплавающее" : "Земноводное") << ", "
-                    << "Климат: " << climateName << ", "
-                    << "Пол: " << (animal.gender == 'M' ? "М" : "Ж") << ", ";
-                animal.printParents();
-                cout << "\n";
+                watched.push_back({ session->broken ? -1 : session->socket, events, 0 });
+            }
+            if (poll(watched.data(), watched.size(), 100) < 0) { // Раз в 100 мс проверяем остановку
+                if (errno == EINTR) continue;
+                throw runtime_error(string("Ошибка poll: ") + strerror(errno));
+            }
+            if (watched[1].revents & POLLIN) {
+                while (read(wakeRead, buffer, sizeof(buffer)) > 0) {}
+            }
+            for (size_t i = 0; i < sessions.size(); ++i) {
+                Session& session = *sessions[i];
+                short revents = watched[i + 2].revents;
+                if (revents & (POLLERR | POLLHUP | POLLNVAL)) {
+                    session.broken = true; // Клиент закрыл соединение целиком: ответы некому читать
+                    continue;
+                }
+                if (revents & POLLIN) receive(session, buffer, sizeof(buffer));
+                if (revents & POLLOUT) transmit(session);
             }
+            if (watched[0].revents & POLLIN) acceptClients();
+            scheduleAndReap();
         }
-        break;
     }
-    case 4: { // Лечение животного
-        cout << "\n--- Лечение животных ---\n";
-        if (zoo.enclosures.empty()) {
-            cout << "У вас нет вольеров!\n";
-            break;
-        }
+    /**
+     * @brief Количество рабочих потоков.
+     */
+    size_t threadCount() const {
+        return pool.threadCount();
+    }
+    /**
+     * @brief Сеансов с запуска сервера.
+     */
+    uint64_t sessionsServed() const {
+        return served;
+    }
+    /**
+     * @brief Выполнено команд с запуска сервера.
+     */
+    uint64_t commandsExecuted() const {
+        return executed.load(memory_order_relaxed);
+    }
 
-        // Вывод списка вольеров
-        int index = 1;
-        for (auto& enc : zoo.enclosures) {
-            string climateName;
-            switch (enc.climate) {
-            case Animal::DESERT: climateName = "Пустыня"; break;
-            case Animal::FOREST: climateName = "Лес"; break;
-            case Animal::ARCTIC: climateName = "Арктика"; break;
-            case Animal::OCEAN: climateName = "Океан"; break;
+private:
+    /**
+     * @brief Сеанс одного клиента.
+     */
+    struct Session {
+        int socket;                 ///< Сокет клиента
+        int sendFlags;              ///< Флаги send (noSigpipeFlags)
+        string input;               ///< Начало недочитанной команды (поток ввода-вывода)
+        bool readClosed = false;    ///< Клиент закончил передачу или нарушил протокол (поток ввода-вывода)
+        bool broken = false;        ///< Соединение оборвано (поток ввода-вывода)
+        mutex lock;                 ///< Защищает поля ниже
+        deque<string> commands;     ///< Команды, ждущие выполнения
+        string output;              ///< Ответы, ждущие отправки
+        bool scheduled = false;     ///< Задача сеанса стоит в пуле или выполняется
+        bool quit = false;          ///< Клиент закрыл сеанс командой quit
+        unique_ptr<Zoo> zoo;        ///< Зоопарк сеанса; его трогает только задача сеанса
+
+        explicit Session(int client) : socket(client), sendFlags(noSigpipeFlags(client)) {}
+    };
+
+    string path;                    ///< Путь к сокету
+    size_t maxSessions;             ///< Наибольшее число одновременных сеансов
+    size_t sessionLimit;            ///< Предел животных, вольеров и сотрудников сеанса
+    int listener = -1;              ///< Слушающий сокет
+    int wakeRead = -1;              ///< Канал пробуждения: читает поток ввода-вывода
+    int wakeWrite = -1;             ///< Канал пробуждения: пишут задачи сеансов
+    vector<unique_ptr<Session>> sessions; ///< Открытые сеансы (поток ввода-вывода)
+    uint64_t served = 0;            ///< Принято сеансов
+    atomic<uint64_t> executed{ 0 }; ///< Выполнено команд
+    shared_mutex speciesLock;       ///< Размножение пишет в общую SpeciesTable, остальные команды её читают
+    WorkStealingPool pool;          ///< Пул задач сеансов; останавливается первым
+
+    /**
+     * @brief Принимает ожидающие соединения; сверх maxSessions клиент получает отказ.
+     */
+    void acceptClients() {
+        while (true) {
+            int client = accept(listener, nullptr, nullptr);
+            if (client < 0) return;
+            if (sessions.size() >= maxSessions) {
+                static const char full[] = "error сервер заполнен\n";
+                send(client, full, sizeof(full) - 1, noSigpipeFlags(client));
+                ::close(client);
+                continue;
             }
-            cout << index << ". Климат: " << climateName
-                << ", Животных: " << enc.animals.size() << "/" << enc.capacity << "\n";
-            index++;
+            fcntl(client, F_SETFL, fcntl(client, F_GETFL) | O_NONBLOCK);
+            sessions.push_back(make_unique<Session>(client));
+            served++;
         }
-
-        // Выбор вольера
-        int enclosureChoice = getIntegerInput("Введите номер вольера: ");
-        if (enclosureChoice <= 0 || enclosureChoice > zoo.enclosures.size()) {
-            cout << "Неверный номер вольера!\n";
-            break;
+    }
+    /**
+     * @brief Читает данные клиента и раскладывает целые строки в очередь команд.
+     */
+    void receive(Session& session, char* buffer, size_t size) {
+        ssize_t n = recv(session.socket, buffer, size, 0);
+        if (n < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) session.broken = true;
+            return;
         }
-
-        auto encIt = zoo.enclosures.begin();
-        advance(encIt, enclosureChoice - 1);
-
-        // Проверка, есть ли больные животные в вольере
-        bool hasInfected = false;
-        for (auto& animal : encIt->animals) {
-            if (animal.isInfected) {
-                hasInfected = true;
-                break;
-            }
+        lock_guard<mutex> guard(session.lock);
+        if (n == 0) {
+            session.readClosed = true;
+            if (!session.input.empty()) session.commands.push_back(move(session.input)); // Последняя строка без перевода
+            string().swap(session.input);
+            return;
         }
-        if (!hasInfected) {
-            cout << "В этом вольере нет больных животных!\n";
-            break;
+        session.input.append(buffer, static_cast<size_t>(n));
+        size_t start = 0, end;
+        while ((end = session.input.find('\n', start)) != string::npos) {
+            size_t length = end - start;
+            if (length > 0 && session.input[end - 1] == '\r') length--;
+            session.commands.emplace_back(session.input, start, min(length, MAX_LINE + 1));
+            start = end + 1;
+            if (length > MAX_LINE) break;
         }
-
-        // Вывод списка больных животных
-        cout << "\nБольные животные в вольере:\n";
-        index = 1;
-        for (auto& animal : encIt->animals) {
-            if (animal.isInfected) {
-                cout << index << ". " << animal.name << ", Возраст: " << animal.ageInDays
-                    << ", Вес: " << animal.weight << "\n";
-                index++;
-            }
+        session.input.erase(0, start);
+        if (session.input.size() > MAX_LINE) session.commands.emplace_back(session.input, 0, MAX_LINE + 1);
+        if (!session.commands.empty() && session.commands.back().size() > MAX_LINE) {
+            // Клиент нарушил протокол: execute ответит ошибкой после принятых команд, затем сеанс закроется
+            session.readClosed = true;
+            string().swap(session.input);
         }
-
-        // Выбор животного для лечения
-        int animalChoice = getIntegerInput("Введите номер животного для лечения: ");
-        if (animalChoice <= 0 || animalChoice > index - 1) {
-            cout << "Неверный номер животного!\n";
-            break;
+    }
+    /**
+     * @brief Отправляет накопленные ответы, сколько примет сокет.
+     */
+    void transmit(Session& session) {
+        lock_guard<mutex> guard(session.lock);
+        ssize_t n = send(session.socket, session.output.data(), session.output.size(), session.sendFlags);
+        if (n < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) session.broken = true;
+            return;
         }
-
-        int count = 0;
-        for (auto& animal : encIt->animals) {
-            if (animal.isInfected) {
-                count++;
-                if (count == animalChoice) {
-                    zoo.cureAnimal(animal.name); // Вызов метода лечения
-                    break;
+        session.output.erase(0, static_cast<size_t>(n));
+        if (session.output.empty() && session.output.capacity() > MAX_LINE) {
+            string().swap(session.output); // Простаивающий сеанс не держит большой буфер
+        }
+    }
+    /**
+     * @brief Ставит в пул сеансы с командами и закрывает завершённые сеансы.
+     */
+    void scheduleAndReap() {
+        for (size_t i = 0; i < sessions.size();) {
+            Session& session = *sessions[i];
+            bool finished;
+            {
+                lock_guard<mutex> guard(session.lock);
+                if (!session.broken && !session.scheduled && !session.quit && !session.commands.empty()
+                    && session.output.size() < MAX_OUTPUT) {
+                    session.scheduled = true;
+                    pool.submit([this, &session]() { serve(session); });
                 }
+                bool done = session.quit || (session.readClosed && session.commands.empty());
+                finished = !session.scheduled && (session.broken || (done && session.output.empty()));
             }
+            if (!finished) {
+                ++i;
+                continue;
+            }
+            ::close(session.socket);
+            sessions[i] = move(sessions.back());
+            sessions.pop_back();
         }
-        break;
     }
-    case 5: { // Обновление рынка
-        zoo.refreshAnimalMarket(zoo.day);
-        break;
+    /**
+     * @brief Будит поток ввода-вывода: появились ответы или сеанс освободился.
+     */
+    void wake() {
+        char signal = 1;
+        if (write(wakeWrite, &signal, 1) < 0) {} // Полный канал и так разбудит poll
     }
-    case 6: { // Размножение животных
-        cout << "\n--- Размножение животных ---\n";
-        if (zoo.enclosures.empty()) {
-            cout << "У вас нет вольеров!\n";
-            break;
-        }
-
-        // Вывод списка вольеров
-        int index = 1;
-        for (auto& enc : zoo.enclosures) {
-            string climateName;
-            switch (enc.climate) {
-            case Animal::DESERT: climateName = "Пустыня"; break;
-            case Animal::FOREST: climateName = "Лес"; break;
-            case Animal::ARCTIC: climateName = "Арктика"; break;
-            case Animal::OCEAN: climateName = "Океан"; break;
+    /**
+     * @brief Задача пула: выполняет до BATCH команд сеанса.
+     */
+    void serve(Session& session) {
+        ZOO_TRACE_SCOPE("session");
+        thread_local OutputSink silent(OutputSink::SILENT);
+        SinkScope scope(silent);
+        for (int i = 0; i < BATCH; ++i) {
+            string command;
+            {
+                lock_guard<mutex> guard(session.lock);
+                if (session.quit || session.commands.empty() || session.output.size() >= MAX_OUTPUT) break;
+                command = move(session.commands.front());
+                session.commands.pop_front();
             }
-            cout << index << ". Климат: " << climateName
-                << ", Животных: " << enc.animals.size() << "/" << enc.capacity << "\n";
-            index++;
+            string reply = execute(session, command);
+            lock_guard<mutex> guard(session.lock);
+            session.output += reply;
         }
-
-        // Выбор вольера
-        int enclosureChoice = getIntegerInput("Введите номер вольера: ");
-        if (enclosureChoice <= 0 || enclosureChoice > zoo.enclosures.size()) {
-            cout << "Неверный номер вольера!\n";
-            break;
+        {
+            lock_guard<mutex> guard(session.lock);
+            session.scheduled = false;
         }
-
-        auto encIt = zoo.enclosures.begin();
-        advance(encIt, enclosureChoice - 1);
-
-        // Вызов метода размножения
-        encIt->breedAnimals(zoo);
-        break;
+        wake();
     }
-    case 7: { // Изменение имени животного
-        cout << "--- Изменение имени животного ---\n";
-        renameAnimal(zoo);
-        break;
+    /**
+     * @brief Животных, вольеров и сотрудников в зоопарке (ограничивается sessionLimit).
+     */
+    static size_t objectCount(const Zoo& zoo) {
+        return static_cast<size_t>(zoo.getTotalAnimals()) + zoo.enclosures.size() + zoo.employees.size();
     }
-    case 0:
-        return;
+    /**
+     * @brief Название вида для ответа: пробелы заменены подчёркиваниями, как в файле устройства.
+     */
+    static string speciesToken(const string& species) {
+        string token = species;
+        replace(token.begin(), token.end(), ' ', '_');
+        return token;
     }
-}
-/**
- * @brief Управляет ресурсами зоопарка.
- * @param zoo Ссылка на объект зоопарка
- */
-void manageResources(Zoo& zoo) {
-    cout << "\n--- Управление ресурсами ---\n";
-    cout << "1. Купить еду\n";
-    cout << "2. Заказать рекламу\n";
-    cout << "0. Назад\n";
-
-    int choice = getIntegerInput("Выберите действие: ");
-    switch (choice) {
-    case 1: {
-        cout << "\nПокупка еды:\n";
-        int amount = getIntegerInput("Сколько кг еды хотите купить? ");
-        if (amount <= 0) {
-            cout << "Неверное количество!\n";
-            break;
-        }
-
-        int cost = amount * 2; // Цена еды: 2 монеты за 1 кг
-        if (zoo.money < cost) {
-            cout << "Недостаточно средств для покупки!\n";
-            break;
-        }
-
-        zoo.food += amount;
-        zoo.money -= cost;
-        cout << "Куплено " << amount << " кг еды за " << cost << " монет.\n";
-        break;
+    /**
+     * @brief Ответ на status и day: состояние зоопарка одной строкой.
+     */
+    static string statusLine(const Zoo& zoo) {
+        ostringstream out;
+        out << "ok day " << zoo.day << " money " << zoo.money << " food " << zoo.food
+            << " popularity " << zoo.popularity << " animals " << zoo.getTotalAnimals()
+            << " infected " << zoo.animalCounts.infected << " enclosures " << zoo.enclosures.size()
+            << " staff " << zoo.employees.size() << " bankrupt " << zoo.isBankrupt()
+            << " hash " << zoo.stateHash() << "\n";
+        return out.str();
     }
-    case 2: {
-        const int COST_PER_POPULARITY = 20; // Стоимость одной единицы популярности
-        cout << "Стоимость одной единицы популярности: " << COST_PER_POPULARITY << " монет\n";
-
-        int cost = getIntegerInput("Введите сумму для рекламной кампании: ");
-        if (cost <= 0) {
-            cout << "Неверная сумма!\n";
-            break;
-        }
-
-        if (zoo.money >= cost) {
-            int popularityIncrease = cost / COST_PER_POPULARITY; // Рассчитываем прирост популярности
-            zoo.money -= cost;
-            zoo.popularity += popularityIncrease;
-
-            cout << "Популярность увеличена на " << popularityIncrease << "!\n";
+    /**
+     * @brief Выполняет одну команду сеанса.
+     * @param session Сеанс
+     * @param line Строка команды
+     * @return Ответ: строка "ok ..." или "error ..."; ответы offers и animals — "ok N" и N строк.
+     */
+    string execute(Session& session, const string& line) {
+        executed.fetch_add(1, memory_order_relaxed);
+        if (line.size() > MAX_LINE) return "error команда длиннее " + to_string(MAX_LINE) + " байт\n";
+        istringstream in(line);
+        string action;
+        if (!(in >> action)) return "error пустая команда\n";
+        unique_ptr<Zoo>& zoo = session.zoo;
+        try {
+            // Размножение дописывает гибриды в общую таблицу видов, остальные команды её только читают
+            unique_lock<shared_mutex> writing(speciesLock, defer_lock);
+            shared_lock<shared_mutex> reading(speciesLock, defer_lock);
+            if (action == "breed") writing.lock();
+            else reading.lock();
+
+            if (action == "quit") {
+                lock_guard<mutex> guard(session.lock);
+                session.quit = true;
+                return "ok\n";
+            }
+            if (action == "zoo") {
+                uint64_t seed;
+                int money;
+                if (!(in >> seed >> money) || money < 0) return "error ожидается 'zoo <зерно> <капитал> <название>'\n";
+                zoo = make_unique<Zoo>(readJournalString(in), money, seed, EVENT_CAPACITY);
+                zoo->hireEmployee("Егор Потрошила", "Директор", 50, 50);
+                return "ok\n";
+            }
+            if (!zoo) return "error сначала 'zoo <зерно> <капитал> <название>'\n";
+
+            if (action == "status") return statusLine(*zoo);
+            if (action == "day") {
+                int count = 1;
+                if (!(in >> count)) count = 1;
+                if (count < 1 || count > MAX_DAYS) return "error число дней от 1 до " + to_string(MAX_DAYS) + "\n";
+                for (int i = 0; i < count; ++i) zoo->nextDay();
+                return statusLine(*zoo);
+            }
+            if (action == "offers") {
+                ostringstream out;
+                out << "ok " << zoo->animalMarket.size() << "\n";
+                for (size_t i = 0; i < zoo->animalMarket.size(); ++i) {
+                    const Animal& animal = zoo->animalMarket[i];
+                    out << i << " " << speciesToken(animal.speciesName()) << " " << animal.ageInDays << " "
+                        << animal.weight << " " << animal.gender() << " " << animal.isCarnivore() << " "
+                        << animal.climate() << " " << animal.calculatePrice() << "\n";
+                }
+                return out.str();
+            }
+            if (action == "animals") {
+                size_t enclosure;
+                if (!(in >> enclosure) || enclosure >= zoo->enclosures.size()) return "error нет такого вольера\n";
+                const Enclosure& enc = zoo->enclosures[enclosure];
+                ostringstream out;
+                out << "ok " << enc.animals.size() << "\n";
+                for (size_t i = 0; i < enc.animals.size(); ++i) {
+                    Animal animal = enc.animals.get(i, zoo->day);
+                    out << i << " " << animal.id << " " << speciesToken(animal.speciesName()) << " "
+                        << animal.ageInDays << " " << animal.weight << " " << animal.gender() << " "
+                        << animal.isInfected() << " " << animal.name << "\n";
+                }
+                return out.str();
+            }
+            bool grows = action == "build" || action == "buy" || action == "breed" || action == "hire";
+            if (grows && objectCount(*zoo) >= sessionLimit) {
+                return "error предел сеанса: " + to_string(sessionLimit) + " животных, вольеров и сотрудников\n";
+            }
+            if (action == "breed") {
+                size_t enclosure, parent1, parent2;
+                if (!(in >> enclosure >> parent1 >> parent2) || enclosure >= zoo->enclosures.size()) {
+                    return "error ожидается 'breed <вольер> <родитель> <родитель> [имя]'\n";
+                }
+                if (!zoo->enclosures[enclosure].canBreed(parent1, parent2)) {
+                    return "error пару не размножить: нужны два разнополых животных старше 5 дней\n";
+                }
+                string name = readJournalString(in);
+                vector<string> born = zoo->enclosures[enclosure].breedPair(parent1, parent2, [&name](SpeciesId species) {
+                    return name.empty() ? SpeciesTable::instance().name(species) : name;
+                });
+                return "ok " + to_string(born.size()) + "\n";
+            }
+            switch (applyZooAction(*zoo, action, in)) {
+            case ActionResult::DONE: return "ok\n";
+            case ActionResult::FAILED: return "error действие '" + action + "' не выполнилось\n";
+            default: return "error неизвестная команда '" + action + "'\n";
+            }
         }
-        else {
-            cout << "Недостаточно средств!\n";
+        catch (const exception& e) {
+            return string("error ") + e.what() + "\n";
         }
-        break;
-    }
-    case 0:
-        return;
     }
+};
+
+/**
+ * @brief Запускает сервер сеансов и обслуживает клиентов до SIGINT или SIGTERM.
+ * @param options Параметры запуска (--serve, --threads, --max-sessions, --session-limit)
+ * @return Код завершения программы.
+ * @throws runtime_error Если сокет не создаётся.
+ */
+int runServer(const HeadlessOptions& options) {
+    SessionServer server(options.servePath, options.threads, options.maxSessions, options.sessionLimit);
+    signal(SIGINT, [](int) { sessionServerStop = 1; });
+    signal(SIGTERM, [](int) { sessionServerStop = 1; });
+    cout << "Сервер сеансов: " << options.servePath << ", потоков " << server.threadCount()
+        << ", сеансов не больше " << options.maxSessions << endl;
+    server.run();
+    cout << "Сервер остановлен: сеансов " << server.sessionsServed() << ", команд " << server.commandsExecuted() << "\n";
+    return 0;
 }
+#endif
+
 /**
- * @brief Главная функция программы.
+ * @brief Интерактивная игра через текстовое меню.
+ * @details Ответы берутся из текущего источника ввода (см. InputScope), поэтому
+ * записанный сеанс проходит через те же меню, что и игра с клавиатуры.
+ * @param journalPath Файл журнала действий для --replay или пустая строка
  * @return Код завершения программы.
+ * @throws InputExhausted Если ввод закончился до конца игры.
  */
-int main() {
-    srand(time(0));
+int runInteractive(const string& journalPath = "") {
     system("chcp 1251 > nul");
     setlocale(LC_ALL, "Russian");
 
     string zooName;
     cout << "Введите название зоопарка: ";
 
-    // Очистка буфера ввода
-    cin.clear(); // Сбрасываем флаги ошибок
-    cin.sync();  // Синхронизируем поток ввода
-    getline(cin, zooName); // Теперь корректно считываем строку
+    zooName = getLineInput();
 
     int initialMoney = getIntegerInput("Введите начальный капитал: ");
     while (initialMoney < 0) {
@@ -1677,8 +6757,11 @@ int main() {
         initialMoney = getIntegerInput("Введите начальный капитал: ");
     }
 
-    Zoo zoo(zooName, initialMoney);
-    zoo.employees.emplace_back("Егор Потрошила", "Директор", 50, 50);
+    Zoo zoo(zooName, initialMoney, static_cast<uint64_t>(time(0)));
+    zoo.hireEmployee("Егор Потрошила", "Директор", 50, 50);
+    if (!journalPath.empty()) {
+        zoo.startJournal(journalPath);
+    }
 
     while (true) {
         cout << "\n\n=== " << zoo.name << " ===\n";
@@ -1695,6 +6778,8 @@ int main() {
         cout << "[2] Работники\n";
         cout << "[3] Вольеры\n";
         cout << "[4] Ресурсы\n";
+        cout << "[5] Журнал событий\n";
+        cout << "[6] Прогноз на 10 дней\n";
         cout << "[0] Следующий день\n";
 
         int choice = getIntegerInput("Ваш выбор: ");
@@ -1721,7 +6806,81 @@ int main() {
         else if (choice == 4) {
             manageResources(zoo);
         }
+        else if (choice == 5) {
+            showEventLog(zoo);
+        }
+        else if (choice == 6) {
+            showForecast(zoo, "", nullptr);
+        }
     }
 
     return 0;
-}
\ No newline at end of file
+}
+
+/**
+ * @brief Главная функция программы.
+ * @details Без аргументов запускается интерактивное меню; --script FILE (или "-" для
+ * стандартного ввода) и --script-command CMD проводят через меню записанный сеанс, --journal FILE
+ * записывает действия игрока, --replay FILE воспроизводит их без меню со сверкой хеша. С аргументами
+ * (--headless, --seed, --money, --days, --layout, --name, --check-tick, --legacy-spread,
+ * --legacy-aging, --output, --log-level, --event-log, --restore, --snapshot, --checkpoint, --metrics, --trace) — пакетное моделирование,
+ * --print-events FILE — печать файла журнала событий, --print-metrics FILE — печать файла показателей в CSV,
+ * с --monte-carlo N [--threads T] — серия из N прогонов на пуле потоков,
+ * --serve SOCKET [--threads T] [--max-sessions N] [--session-limit N] — сервер сеансов игры.
+ * Не компилируется при ZOO_NO_MAIN (сборка zoo_bench, см. ZooBench.cpp).
+ * @return Код завершения программы.
+ */
+#ifndef ZOO_NO_MAIN
+int main(int argc, char* argv[]) {
+    try {
+        if (argc == 3 && string(argv[1]) == "--replay") {
+            return runReplay(argv[2]);
+        }
+        // Интерактивная игра: --script или --script-command и --journal в любом сочетании
+        bool interactive = argc % 2 == 1;
+        for (int i = 1; interactive && i < argc; i += 2) {
+            string arg = argv[i];
+            interactive = arg == "--script" || arg == "--script-command" || arg == "--journal";
+        }
+        if (interactive) {
+            unique_ptr<InputSource> source;
+            string journalPath;
+            for (int i = 1; i < argc; i += 2) {
+                string arg = argv[i];
+                if (arg == "--script") source = make_unique<FileInput>(argv[i + 1]);
+                else if (arg == "--script-command") source = make_unique<PipeInput>(argv[i + 1]);
+                else journalPath = argv[i + 1];
+            }
+            if (!source) return runInteractive(journalPath);
+            InputScope scope(*source);
+            return runInteractive(journalPath);
+        }
+        HeadlessOptions options = parseHeadlessOptions(argc, argv);
+        if (!options.printEventsPath.empty()) return printEventFile(options.printEventsPath);
+        if (!options.printMetricsPath.empty()) return printMetricsFile(options.printMetricsPath);
+        auto run = [&options]() {
+#ifndef _WIN32
+            if (!options.servePath.empty()) return runServer(options);
+#endif
+            return options.replicas > 0 ? runMonteCarloHeadless(options) : runHeadless(options);
+        };
+        if (options.tracePath.empty()) return run();
+        Tracer& tracer = Tracer::instance();
+        Tracer::nameThread("main");
+        tracer.start();
+        int code = run();
+        cout << "Трасса: " << tracer.writeJson(options.tracePath) << " отрезков в " << options.tracePath;
+        if (tracer.dropped() > 0) cout << " (отброшено " << tracer.dropped() << ")";
+        cout << "\n";
+        return code;
+    }
+    catch (const InputExhausted&) {
+        cout << "\nВвод закончился.\n";
+        return 0;
+    }
+    catch (const exception& e) {
+        cerr << "Ошибка: " << e.what() << "\n";
+        return 2;
+    }
+}
+#endif // ZOO_NO_MAIN
\ No newline at end of file